@@ -0,0 +1,257 @@
+#include "SimView.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace SimView
+{
+	static const char archiveMagic[4] = { 'S', 'V', 'A', 'R' };
+	static const std::uint32_t archiveVersion = 1;
+	static const std::uint64_t payloadAlignment = 64;
+
+	static std::uint64_t AlignOffset(std::uint64_t offset)
+	{
+		return (offset + payloadAlignment - 1) & ~(payloadAlignment - 1);
+	}
+
+	static const int maxDimension = 1 << 16;
+
+	// RGBA8 is stored as pixels, the block formats as CompressedImage writes them
+	static bool IsSupportedFormat(GLenum internalFormat)
+	{
+		return internalFormat == GL_RGBA8 || internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+			|| internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || internalFormat == GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+
+	static std::uint64_t LevelSize(GLenum internalFormat, int width, int height, int level)
+	{
+		return GpuMemory::GetTextureBytes(internalFormat, std::max(width >> level, 1), std::max(height >> level, 1), 1);
+	}
+
+	// Overflow safe offset + size <= limit
+	static bool InRange(std::uint64_t offset, std::uint64_t size, std::uint64_t limit)
+	{
+		return offset <= limit && size <= limit - offset;
+	}
+
+	static std::vector<unsigned char> BitmapBytes(const Bitmap& image)
+	{
+		const unsigned char* bytes = (const unsigned char*)image.data;
+		return std::vector<unsigned char>(bytes, bytes + size_t(image.width) * image.height * sizeof(Color));
+	}
+
+
+	// Writer
+
+	void AssetArchiveWriter::Add(std::string name, const Bitmap& image, bool mipmaps, ResampleFilter filter)
+	{
+		if (image.format != PixelFormat::RGBA8)
+			throw std::runtime_error("AssetArchive Error: Bitmap assets must be RGBA8\n");
+		std::vector<std::vector<unsigned char>> levels;
+		levels.push_back(BitmapBytes(image));
+		if (mipmaps)
+		{
+			std::vector<Bitmap> mips = image.GenMipChain(filter);
+			for (int level = 0; level < (int)mips.size() && (int)levels.size() < AssetArchiveEntry::MaxLevels; level++)
+				levels.push_back(BitmapBytes(mips[level]));
+		}
+		AddLevels(name, image.width, image.height, GL_RGBA8, std::move(levels));
+	}
+
+	void AssetArchiveWriter::Add(std::string name, const CompressedImage& image)
+	{
+		AddLevels(name, image.width, image.height, image.GetInternalFormat(), image.levels);
+	}
+
+	void AssetArchiveWriter::AddLevels(std::string name, int width, int height, GLenum internalFormat, std::vector<std::vector<unsigned char>> levels)
+	{
+		if (!IsSupportedFormat(internalFormat))
+			throw std::runtime_error("AssetArchive Error: Unsupported format for " + name + "\n");
+		if (width < 1 || height < 1 || width > maxDimension || height > maxDimension)
+			throw std::runtime_error("AssetArchive Error: Invalid dimensions for " + name + "\n");
+		if (levels.empty() || (int)levels.size() > std::min((int)AssetArchiveEntry::MaxLevels, Bitmap::MipLevelCount(width, height)))
+			throw std::runtime_error("AssetArchive Error: Invalid level count for " + name + "\n");
+		for (int level = 0; level < (int)levels.size(); level++)
+		{
+			if (levels[level].size() != LevelSize(internalFormat, width, height, level))
+				throw std::runtime_error("AssetArchive Error: Level size does not match the dimensions of " + name + "\n");
+		}
+		entries.push_back({ name, width, height, internalFormat, std::move(levels) });
+	}
+
+	void AssetArchiveWriter::Write(std::string path)
+	{
+		// Layout: header, entry table, name table, then every level payload aligned for direct upload
+		AssetArchiveHeader header = {};
+		std::memcpy(header.magic, archiveMagic, sizeof(archiveMagic));
+		header.version = archiveVersion;
+		header.entryCount = (std::uint32_t)entries.size();
+		header.indexOffset = AlignOffset(sizeof(AssetArchiveHeader));
+		header.namesOffset = header.indexOffset + entries.size() * sizeof(AssetArchiveEntry);
+
+		std::vector<AssetArchiveEntry> table(entries.size());
+		std::uint64_t offset = header.namesOffset;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			table[i].nameOffset = offset;
+			table[i].nameLength = (std::uint32_t)entries[i].name.size();
+			offset += entries[i].name.size();
+		}
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			AssetArchiveEntry& entry = table[i];
+			entry.width = entries[i].width;
+			entry.height = entries[i].height;
+			entry.levelCount = (std::uint32_t)entries[i].levels.size();
+			entry.internalFormat = entries[i].internalFormat;
+			for (size_t level = 0; level < entries[i].levels.size(); level++)
+			{
+				offset = AlignOffset(offset);
+				entry.levelOffsets[level] = offset;
+				entry.levelSizes[level] = entries[i].levels[level].size();
+				offset += entries[i].levels[level].size();
+			}
+		}
+
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("AssetArchive Error: Failed to open " + path + " for writing\n");
+
+		std::uint64_t written = 0;
+		auto writeAt = [&](std::uint64_t at, const void* data, size_t size)
+		{
+			static const char zeros[payloadAlignment] = {};
+			out.write(zeros, at - written);
+			out.write((const char*)data, size);
+			written = at + size;
+		};
+
+		writeAt(0, &header, sizeof(header));
+		writeAt(header.indexOffset, table.data(), table.size() * sizeof(AssetArchiveEntry));
+		for (size_t i = 0; i < entries.size(); i++)
+			writeAt(table[i].nameOffset, entries[i].name.data(), entries[i].name.size());
+		for (size_t i = 0; i < entries.size(); i++)
+			for (size_t level = 0; level < entries[i].levels.size(); level++)
+				writeAt(table[i].levelOffsets[level], entries[i].levels[level].data(), entries[i].levels[level].size());
+
+		if (!out)
+			throw std::runtime_error("AssetArchive Error: Failed to write " + path + "\n");
+	}
+
+
+	// Reader
+
+	AssetArchive::AssetArchive(std::string path) : file(path)
+	{
+		if (file.size < sizeof(AssetArchiveHeader))
+			throw std::runtime_error("AssetArchive Error: " + path + " is not an asset archive\n");
+
+		header = (const AssetArchiveHeader*)file.data;
+		if (std::memcmp(header->magic, archiveMagic, sizeof(archiveMagic)) != 0 || header->version != archiveVersion)
+			throw std::runtime_error("AssetArchive Error: " + path + " is not a supported asset archive\n");
+		if (!InRange(header->indexOffset, std::uint64_t(header->entryCount) * sizeof(AssetArchiveEntry), file.size))
+			throw std::runtime_error("AssetArchive Error: " + path + " is truncated\n");
+
+		entries = (const AssetArchiveEntry*)(file.data + header->indexOffset);
+		for (std::uint32_t i = 0; i < header->entryCount; i++)
+		{
+			const AssetArchiveEntry& entry = entries[i];
+			// Level sizes must match the dimensions and format, so loads never read past a payload
+			bool valid = InRange(entry.nameOffset, entry.nameLength, file.size) && IsSupportedFormat(entry.internalFormat)
+				&& entry.width >= 1 && entry.height >= 1 && entry.width <= maxDimension && entry.height <= maxDimension
+				&& entry.levelCount >= 1 && entry.levelCount <= (std::uint32_t)std::min((int)AssetArchiveEntry::MaxLevels, Bitmap::MipLevelCount(entry.width, entry.height));
+			for (std::uint32_t level = 0; valid && level < entry.levelCount; level++)
+			{
+				valid = entry.levelSizes[level] == LevelSize(entry.internalFormat, entry.width, entry.height, level)
+					&& InRange(entry.levelOffsets[level], entry.levelSizes[level], file.size);
+			}
+			if (!valid)
+				throw std::runtime_error("AssetArchive Error: " + path + " has a corrupt entry table\n");
+
+			index[std::string((const char*)file.data + entry.nameOffset, entry.nameLength)] = i;
+		}
+	}
+
+	bool AssetArchive::Contains(std::string name) const
+	{
+		return index.contains(name);
+	}
+
+	const AssetArchiveEntry& AssetArchive::GetEntry(std::string name) const
+	{
+		auto it = index.find(name);
+		if (it == index.end())
+			throw std::runtime_error("AssetArchive Error: Asset " + name + " not found\n");
+		return entries[it->second];
+	}
+
+	const unsigned char* AssetArchive::GetLevelData(const AssetArchiveEntry& entry, int level) const
+	{
+		return file.data + entry.levelOffsets[level];
+	}
+
+	// Levels are read straight from the mapping, so no pixel buffer may be bound and rows are tightly packed
+	static void ResetUnpackState()
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	Bitmap AssetArchive::LoadBitmap(std::string name) const
+	{
+		const AssetArchiveEntry& entry = GetEntry(name);
+		if (entry.internalFormat != GL_RGBA8)
+			throw std::runtime_error("AssetArchive Error: Asset " + name + " is not stored as RGBA8\n");
+		return Bitmap(entry.width, entry.height, (const Color*)GetLevelData(entry, 0));
+	}
+
+	Texture AssetArchive::LoadTexture(std::string name) const
+	{
+		const AssetArchiveEntry& entry = GetEntry(name);
+		Texture texture(entry.width, entry.height, entry.levelCount, entry.internalFormat);
+
+		// Payloads are uploaded straight out of the mapping, no intermediate decode or copy
+		ResetUnpackState();
+		for (std::uint32_t level = 0; level < entry.levelCount; level++)
+		{
+			int width = std::max<int>(entry.width >> level, 1);
+			int height = std::max<int>(entry.height >> level, 1);
+			if (entry.internalFormat == GL_RGBA8)
+				glTextureSubImage2D(texture.id, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, GetLevelData(entry, level));
+			else
+				glCompressedTextureSubImage2D(texture.id, level, 0, 0, width, height, entry.internalFormat, (GLsizei)entry.levelSizes[level], GetLevelData(entry, level));
+		}
+		glTextureParameteri(texture.id, GL_TEXTURE_MAX_LEVEL, entry.levelCount - 1);
+		return texture;
+	}
+
+	void AssetArchive::LoadLayer(TextureArray& texArray, std::string name, int layer) const
+	{
+		const AssetArchiveEntry& entry = GetEntry(name);
+		if ((int)entry.width != texArray.width || (int)entry.height != texArray.height)
+			throw std::runtime_error("AssetArchive Error: Asset " + name + " does not match the texture array size\n");
+		if (entry.internalFormat != texArray.internalFormat || (int)entry.levelCount != texArray.levels)
+			throw std::runtime_error("AssetArchive Error: Asset " + name + " does not match the texture array format or level count\n");
+		if (layer < 0 || layer >= texArray.layers)
+			throw std::runtime_error("AssetArchive Error: Layer out of range\n");
+
+		ResetUnpackState();
+		for (std::uint32_t level = 0; level < entry.levelCount; level++)
+		{
+			int width = std::max<int>(entry.width >> level, 1);
+			int height = std::max<int>(entry.height >> level, 1);
+			if (entry.internalFormat == GL_RGBA8)
+				glTextureSubImage3D(texArray.id, level, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, GetLevelData(entry, level));
+			else
+				glCompressedTextureSubImage3D(texArray.id, level, 0, 0, layer, width, height, 1, entry.internalFormat, (GLsizei)entry.levelSizes[level], GetLevelData(entry, level));
+		}
+	}
+}
\ No newline at end of file
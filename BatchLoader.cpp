@@ -0,0 +1,145 @@
+#include "SimView.hpp"
+#include <atomic>
+
+namespace SimView
+{
+	enum class SlotState
+	{
+		Pending,
+		Ready,
+		Failed,
+	};
+
+	struct BatchLoaderState
+	{
+		std::vector<std::string> paths;
+		PixelFormat format;
+		std::vector<Bitmap> images;
+		std::vector<SlotState> slots;
+		std::mutex mutex;
+		std::condition_variable readyCv;
+		std::atomic<bool> cancelled = false;
+		std::atomic<int> decoded = 0;
+		std::atomic<int> uploaded = 0;
+	};
+
+	BatchLoader::BatchLoader(TextureArray& target, std::vector<std::string> paths, int firstLayer, ThreadPool& pool)
+	{
+		this->target = &target;
+		this->firstLayer = firstLayer;
+
+		state = std::make_shared<BatchLoaderState>();
+		state->format = target.format;
+		state->images.resize(paths.size());
+		state->slots.resize(paths.size(), SlotState::Pending);
+		state->paths = std::move(paths);
+
+		// Each task holds the shared state, so a destroyed loader only has to cancel outstanding decodes
+		for (int i = 0; i < (int)state->paths.size(); i++)
+		{
+			pool.Submit([state = state, i]()
+			{
+				if (state->cancelled)
+					return;
+
+				Bitmap image;
+				SlotState result = SlotState::Ready;
+				try
+				{
+					image = Bitmap::FromFile(state->paths[i], state->format);
+				}
+				catch (const std::exception&)
+				{
+					result = SlotState::Failed;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(state->mutex);
+					state->images[i] = std::move(image);
+					state->slots[i] = result;
+				}
+				state->decoded++;
+				state->readyCv.notify_all();
+			});
+		}
+	}
+
+	BatchLoader::~BatchLoader()
+	{
+		Cancel();
+	}
+
+	int BatchLoader::Poll(int maxUploads)
+	{
+		int uploads = 0;
+		while (!IsDone() && (maxUploads < 0 || uploads < maxUploads))
+		{
+			int index = state->uploaded;
+			Bitmap image;
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (state->slots[index] == SlotState::Pending)
+					break;
+				if (state->slots[index] == SlotState::Failed)
+					throw std::runtime_error("BatchLoader Error: Failed to load image " + state->paths[index] + "\n");
+				image = std::move(state->images[index]);
+			}
+
+			// Layers are uploaded in order on the calling thread, which owns the GL context
+			target->LayerFromBitmap(image, firstLayer + index);
+			state->uploaded++;
+			uploads++;
+		}
+		return uploads;
+	}
+
+	void BatchLoader::Finish(std::function<void(int uploaded, int total)> progress)
+	{
+		while (!IsDone())
+		{
+			{
+				std::unique_lock<std::mutex> lock(state->mutex);
+				int index = state->uploaded;
+				state->readyCv.wait(lock, [&] { return state->slots[index] != SlotState::Pending || state->cancelled; });
+			}
+			if (Poll() > 0 && progress)
+				progress(GetUploadedCount(), GetTotal());
+		}
+	}
+
+	void BatchLoader::Cancel()
+	{
+		state->cancelled = true;
+		state->readyCv.notify_all();
+	}
+
+	bool BatchLoader::IsDone() const
+	{
+		return state->cancelled || state->uploaded == GetTotal();
+	}
+
+	bool BatchLoader::IsCancelled() const
+	{
+		return state->cancelled;
+	}
+
+	int BatchLoader::GetDecodedCount() const
+	{
+		return state->decoded;
+	}
+
+	int BatchLoader::GetUploadedCount() const
+	{
+		return state->uploaded;
+	}
+
+	int BatchLoader::GetTotal() const
+	{
+		return (int)state->paths.size();
+	}
+
+	float BatchLoader::GetProgress() const
+	{
+		return GetTotal() == 0 ? 1.f : GetUploadedCount() / (float)GetTotal();
+	}
+}
\ No newline at end of file
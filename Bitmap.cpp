@@ -1,19 +1,184 @@
 #include "SimView.hpp"
 #include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#define STBI_MALLOC(size) SimView::BitmapPool::Allocate(size)
+#define STBI_REALLOC(ptr, size) SimView::BitmapPool::Reallocate(ptr, size)
+#define STBI_FREE(ptr) SimView::BitmapPool::Free(ptr)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 namespace SimView
 {
+	static std::mutex loadStatsMutex;
+	static ImageLoadStats totalLoadStats;
+
+	static void Adopt(Bitmap& image, void* pixels, int width, int height, PixelFormat format)
+	{
+		// stb_image allocates through BitmapPool, so decoded buffers are adopted as is
+		BitmapPool::Free(image.data);
+		image.data = (Color*)pixels;
+		image.width = width;
+		image.height = height;
+		image.format = format;
+	}
+
+	static bool DecodePixels(const stbi_uc* fileData, int size, PixelFormat format, Bitmap& image)
+	{
+		const PixelFormatInfo& info = PixelFormatInfo::Get(format);
+		int width, height, n;
+
+		if (!info.isFloat)
+		{
+			stbi_uc* pixels = stbi_load_from_memory(fileData, size, &width, &height, &n, info.channels);
+			if (pixels == nullptr)
+				return false;
+			Adopt(image, pixels, width, height, format);
+			return true;
+		}
+
+		// HDR files decode to float directly, everything else goes through the 16-bit path to keep precision
+		float* floats = nullptr;
+		if (stbi_is_hdr_from_memory(fileData, size))
+		{
+			floats = stbi_loadf_from_memory(fileData, size, &width, &height, &n, info.channels);
+			if (floats == nullptr)
+				return false;
+		}
+		else
+		{
+			stbi_us* pixels = stbi_load_16_from_memory(fileData, size, &width, &height, &n, info.channels);
+			if (pixels == nullptr)
+				return false;
+			size_t count = size_t(width) * height * info.channels;
+			floats = (float*)BitmapPool::Allocate(count * sizeof(float));
+			for (size_t i = 0; i < count; i++)
+				floats[i] = pixels[i] / 65535.f;
+			BitmapPool::Free(pixels);
+		}
+
+		if (info.bytes == info.channels * (int)sizeof(float))
+		{
+			Adopt(image, floats, width, height, format);
+			return true;
+		}
+
+		Bitmap halves(width, height, format);
+		Half::FromFloats(floats, halves.As<Half>(), size_t(width) * height * info.channels);
+		BitmapPool::Free(floats);
+		image = std::move(halves);
+		return true;
+	}
+
+	static bool Decode(const void* fileData, size_t size, PixelFormat format, Bitmap& image, ImageLoadStats* stats)
+	{
+		if (size > INT_MAX)
+			return false;
+
+		auto start = std::chrono::steady_clock::now();
+		bool decoded = DecodePixels((const stbi_uc*)fileData, (int)size, format, image);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (stats != nullptr)
+		{
+			stats->imageCount++;
+			stats->bytesRead += size;
+			stats->decodeSeconds += seconds;
+		}
+		std::lock_guard<std::mutex> lock(loadStatsMutex);
+		totalLoadStats.imageCount++;
+		totalLoadStats.bytesRead += size;
+		totalLoadStats.decodeSeconds += seconds;
+		return decoded;
+	}
+
 	Bitmap::~Bitmap()
 	{
-		delete[] data;
+		if (ownsData)
+			BitmapPool::Free(data);
 	}
-	Bitmap::Bitmap(int width, int height, Color* data)
+	Bitmap::Bitmap(int width, int height)
 	{
-		this->width = width;
-		this->height = height;
-		this->data = data;
+		Resize(width, height);
+	}
+	Bitmap::Bitmap(int width, int height, PixelFormat format)
+	{
+		this->format = format;
+		Resize(width, height);
+	}
+	Bitmap::Bitmap(int width, int height, const Color* data)
+	{
+		Resize(width, height);
+		if (data != nullptr)
+			std::copy_n(data, width * height, this->data);
+	}
+	// Copy constructor
+	Bitmap::Bitmap(const Bitmap& other)
+	{
+		this->format = other.format;
+		Resize(other.width, other.height);
+		std::memcpy(data, other.data, GetByteSize());
+		this->dirtyRects = other.dirtyRects;
+		this->tileHashes = other.tileHashes;
+		this->hashTileSize = other.hashTileSize;
+	}
+	// Move constructor
+	Bitmap::Bitmap(Bitmap&& other) noexcept
+	{
+		this->data = other.data;
+		this->width = other.width;
+		this->height = other.height;
+		this->format = other.format;
+		this->ownsData = other.ownsData;
+		this->dirtyRects = std::move(other.dirtyRects);
+		this->tileHashes = std::move(other.tileHashes);
+		this->hashTileSize = other.hashTileSize;
+
+		other.data = nullptr;
+		other.width = 0;
+		other.height = 0;
+		other.ownsData = true;
+	}
+	// Copy assignment
+	Bitmap& Bitmap::operator=(const Bitmap& other)
+	{
+		if (this == &other)
+			return *this;
+		if (!ownsData && other.format != format)
+			throw std::runtime_error("Bitmap Error: Cannot change the format of a bitmap that does not own its data\n");
+
+		this->format = other.format;
+		Resize(other.width, other.height);
+		std::memcpy(data, other.data, GetByteSize());
+		this->dirtyRects = other.dirtyRects;
+		this->tileHashes = other.tileHashes;
+		this->hashTileSize = other.hashTileSize;
+		return *this;
+	}
+	// Move assignment
+	Bitmap& Bitmap::operator=(Bitmap&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (ownsData)
+				BitmapPool::Free(data);
+
+			this->data = other.data;
+			this->width = other.width;
+			this->height = other.height;
+			this->format = other.format;
+			this->ownsData = other.ownsData;
+			this->dirtyRects = std::move(other.dirtyRects);
+			this->tileHashes = std::move(other.tileHashes);
+			this->hashTileSize = other.hashTileSize;
+
+			other.data = nullptr;
+			other.width = 0;
+			other.height = 0;
+			other.ownsData = true;
+		}
+		return *this;
 	}
 	int Bitmap::GetIndex(int x, int y) const
 	{
@@ -21,32 +186,140 @@ namespace SimView
 	}
 	Bitmap Bitmap::GetColorImage(int width, int height, Color color)
 	{
-		Color* data = new Color[width * height];
-		std::fill_n(data, width * height, color);
-		return Bitmap(width,height,data);
+		Bitmap image(width, height);
+		std::fill_n(image.data, width * height, color);
+		return image;
+	}
+	Bitmap Bitmap::Wrap(void* data, int width, int height, PixelFormat format)
+	{
+		Bitmap image;
+		image.data = (Color*)data;
+		image.width = width;
+		image.height = height;
+		image.format = format;
+		image.ownsData = false;
+		return image;
+	}
+	Bitmap Bitmap::FromFile(std::string path, ImageLoadStats* stats)
+	{
+		return FromFile(path, PixelFormat::RGBA8, stats);
 	}
-	Bitmap Bitmap::FromFile(std::string path)
+	Bitmap Bitmap::FromFile(std::string path, PixelFormat format, ImageLoadStats* stats)
 	{
-		int x,y,n;
-		unsigned char* data = stbi_load(path.c_str(), &x, &y, &n, 4);
-		if (data == nullptr)
+		MappedFile file(path);
+		Bitmap image;
+		if (!Decode(file.data, file.size, format, image, stats))
 			throw std::runtime_error("Failed to load image " + path);
-		return Bitmap(x, y, (Color*)data);
+		return image;
+	}
+	Bitmap Bitmap::FromMemory(const void* fileData, size_t size, ImageLoadStats* stats)
+	{
+		return FromMemory(fileData, size, PixelFormat::RGBA8, stats);
+	}
+	Bitmap Bitmap::FromMemory(const void* fileData, size_t size, PixelFormat format, ImageLoadStats* stats)
+	{
+		Bitmap image;
+		if (!Decode(fileData, size, format, image, stats))
+			throw std::runtime_error("Bitmap Error: Failed to decode image from memory\n");
+		return image;
+	}
+	ImageLoadStats Bitmap::GetTotalLoadStats()
+	{
+		std::lock_guard<std::mutex> lock(loadStatsMutex);
+		return totalLoadStats;
+	}
+	void Bitmap::Resize(int width, int height)
+	{
+		size_t bytes = size_t(width) * height * PixelFormatInfo::Get(format).bytes;
+		if (!ownsData)
+		{
+			// Wrapped storage can be written in place but never reallocated
+			if (width != this->width || height != this->height)
+				throw std::runtime_error("Bitmap Error: Cannot resize a bitmap that does not own its data\n");
+			return;
+		}
+		if (bytes > BitmapPool::GetCapacity(data))
+		{
+			BitmapPool::Free(data);
+			data = (Color*)BitmapPool::Allocate(bytes);
+		}
+		this->width = width;
+		this->height = height;
+		if (hashTileSize > 0)
+			EnableTileHashing(hashTileSize);
+	}
+	int Bitmap::GetPixelSize() const
+	{
+		return PixelFormatInfo::Get(format).bytes;
+	}
+	size_t Bitmap::GetByteSize() const
+	{
+		return size_t(width) * height * GetPixelSize();
+	}
+	BitmapView Bitmap::GetView() const
+	{
+		return BitmapView(*this);
+	}
+	BitmapView Bitmap::GetView(int x, int y, int width, int height) const
+	{
+		return BitmapView(*this).SubView(x, y, width, height);
 	}
 	Color Bitmap::GetPixel(int x, int y) const
 	{
+		if (format != PixelFormat::RGBA8)
+			throw std::runtime_error("Bitmap Error: Pixel access requires an RGBA8 bitmap\n");
 		return data[GetIndex(x, y)];
 	}
 	void Bitmap::SetPixel(int x, int y, Color color)
 	{
+		if (format != PixelFormat::RGBA8)
+			throw std::runtime_error("Bitmap Error: Pixel access requires an RGBA8 bitmap\n");
 		data[GetIndex(x, y)] = color;
 	}
-	void Bitmap::DrawBitmap(int oX, int oY, const Bitmap& img)
+	void Bitmap::DrawBitmap(int oX, int oY, const BitmapView& img)
+	{
+		DrawBitmap(oX, oY, img, BlendMode::Default);
+	}
+	void Bitmap::DrawBitmap(int oX, int oY, const BitmapView& img, BlendMode mode)
+	{
+		GetView().DrawBitmap(oX, oY, img, mode);
+		MarkDirty(oX, oY, img.width, img.height);
+	}
+
+	BitmapView::BitmapView(Color* data, int width, int height, int stride)
+	{
+		this->data = data;
+		this->width = width;
+		this->height = height;
+		this->stride = stride;
+	}
+	BitmapView::BitmapView(const Bitmap& bitmap)
 	{
-		for (int x = oX; x < glm::min(oX + img.width, width); x++)
-			for (int y = oY; y < glm::min(oY + img.height, height); y++)
-			{
-				SetPixel(x, y, img.GetPixel(x - oX, y - oY));
-			}
+		if (bitmap.format != PixelFormat::RGBA8)
+			throw std::runtime_error("Bitmap Error: Views and blits require an RGBA8 bitmap\n");
+		this->data = bitmap.data;
+		this->width = bitmap.width;
+		this->height = bitmap.height;
+		this->stride = bitmap.width;
+	}
+	int BitmapView::GetIndex(int x, int y) const
+	{
+		return y * stride + x;
+	}
+	BitmapView BitmapView::SubView(int x, int y, int width, int height) const
+	{
+		int x0 = std::clamp(x, 0, this->width);
+		int y0 = std::clamp(y, 0, this->height);
+		int x1 = std::clamp(x + width, x0, this->width);
+		int y1 = std::clamp(y + height, y0, this->height);
+		return BitmapView(data + GetIndex(x0, y0), x1 - x0, y1 - y0, stride);
+	}
+	Color BitmapView::GetPixel(int x, int y) const
+	{
+		return data[GetIndex(x, y)];
+	}
+	void BitmapView::SetPixel(int x, int y, Color color)
+	{
+		data[GetIndex(x, y)] = color;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "SimView.hpp"
+#include <mutex>
+#include <new>
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace SimView
+{
+	// Every block starts with a header padded to the alignment, so user pointers stay 64-byte aligned
+	struct PoolBlockHeader
+	{
+		size_t capacity;
+		size_t mappedSize;
+		bool largePage;
+	};
+
+	static_assert(sizeof(PoolBlockHeader) <= BitmapPool::Alignment);
+
+	static const size_t largePageThreshold = 2 * 1024 * 1024;
+
+	static std::mutex poolMutex;
+	static std::map<size_t, std::vector<void*>> freeBlocks;
+	static size_t cachedBytes = 0;
+	static size_t cacheBudget = 256 * 1024 * 1024;
+	static size_t heapAllocations = 0;
+	static bool useLargePages = false;
+
+	static PoolBlockHeader* GetHeader(void* ptr)
+	{
+		return (PoolBlockHeader*)((char*)ptr - BitmapPool::Alignment);
+	}
+
+	static size_t RoundCapacity(size_t bytes)
+	{
+		// Small blocks use power of two classes, large ones 64KB steps so equal sized images share a class
+		if (bytes <= 64 * 1024)
+		{
+			size_t capacity = BitmapPool::Alignment;
+			while (capacity < bytes)
+				capacity *= 2;
+			return capacity;
+		}
+		return (bytes + 0xFFFF) & ~size_t(0xFFFF);
+	}
+
+	static void* MapLargePages(size_t bytes, size_t& mappedSize)
+	{
+#ifdef _WIN32
+		size_t pageSize = GetLargePageMinimum();
+		if (pageSize == 0)
+			return nullptr;
+		mappedSize = (bytes + pageSize - 1) / pageSize * pageSize;
+		return VirtualAlloc(nullptr, mappedSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+#else
+		mappedSize = (bytes + largePageThreshold - 1) / largePageThreshold * largePageThreshold;
+		void* ptr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+			return nullptr;
+#ifdef MADV_HUGEPAGE
+		madvise(ptr, mappedSize, MADV_HUGEPAGE);
+#endif
+		return ptr;
+#endif
+	}
+
+	static void UnmapLargePages(void* ptr, size_t mappedSize)
+	{
+#ifdef _WIN32
+		VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+		munmap(ptr, mappedSize);
+#endif
+	}
+
+	static void* AllocateBlock(size_t capacity)
+	{
+		heapAllocations++;
+
+		size_t total = capacity + BitmapPool::Alignment;
+		void* base = nullptr;
+		size_t mappedSize = 0;
+		if (useLargePages && total >= largePageThreshold)
+			base = MapLargePages(total, mappedSize);
+
+		bool largePage = base != nullptr;
+		if (!largePage)
+			base = ::operator new(total, std::align_val_t(BitmapPool::Alignment));
+
+		PoolBlockHeader* header = (PoolBlockHeader*)base;
+		header->capacity = capacity;
+		header->mappedSize = mappedSize;
+		header->largePage = largePage;
+		return (char*)base + BitmapPool::Alignment;
+	}
+
+	static void ReleaseBlock(void* ptr)
+	{
+		PoolBlockHeader* header = GetHeader(ptr);
+		if (header->largePage)
+			UnmapLargePages(header, header->mappedSize);
+		else
+			::operator delete(header, std::align_val_t(BitmapPool::Alignment));
+	}
+
+	// Releases the largest cached blocks until the cache fits its budget, the caller must hold poolMutex
+	static void EvictToBudget()
+	{
+		while (cachedBytes > cacheBudget && !freeBlocks.empty())
+		{
+			auto it = std::prev(freeBlocks.end());
+			if (it->second.empty())
+			{
+				freeBlocks.erase(it);
+				continue;
+			}
+			ReleaseBlock(it->second.back());
+			it->second.pop_back();
+			cachedBytes -= it->first;
+		}
+	}
+
+	void* BitmapPool::Allocate(size_t bytes)
+	{
+		size_t capacity = RoundCapacity(bytes);
+
+		std::lock_guard<std::mutex> lock(poolMutex);
+
+		// Reuse the smallest cached block that fits, as long as it doesn't waste more than a quarter of itself
+		auto it = freeBlocks.lower_bound(capacity);
+		while (it != freeBlocks.end() && it->first - it->first / 4 <= capacity)
+		{
+			if (!it->second.empty())
+			{
+				void* ptr = it->second.back();
+				it->second.pop_back();
+				cachedBytes -= it->first;
+				return ptr;
+			}
+			it++;
+		}
+		return AllocateBlock(capacity);
+	}
+
+	void* BitmapPool::Reallocate(void* ptr, size_t bytes)
+	{
+		if (ptr == nullptr)
+			return Allocate(bytes);
+		size_t capacity = GetHeader(ptr)->capacity;
+		if (bytes <= capacity)
+			return ptr;
+
+		void* newPtr = Allocate(bytes);
+		std::memcpy(newPtr, ptr, capacity);
+		Free(ptr);
+		return newPtr;
+	}
+
+	void BitmapPool::Free(void* ptr)
+	{
+		if (ptr == nullptr)
+			return;
+		size_t capacity = GetHeader(ptr)->capacity;
+
+		std::lock_guard<std::mutex> lock(poolMutex);
+		freeBlocks[capacity].push_back(ptr);
+		cachedBytes += capacity;
+		EvictToBudget();
+	}
+
+	size_t BitmapPool::GetCapacity(void* ptr)
+	{
+		return ptr == nullptr ? 0 : GetHeader(ptr)->capacity;
+	}
+
+	void BitmapPool::SetLargePages(bool enabled)
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		useLargePages = enabled;
+	}
+
+	void BitmapPool::SetCacheBudget(size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		cacheBudget = bytes;
+		EvictToBudget();
+	}
+
+	void BitmapPool::Trim()
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		for (auto& [capacity, blocks] : freeBlocks)
+		{
+			for (void* ptr : blocks)
+				ReleaseBlock(ptr);
+		}
+		freeBlocks.clear();
+		cachedBytes = 0;
+	}
+
+	size_t BitmapPool::GetCachedBytes()
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		return cachedBytes;
+	}
+
+	size_t BitmapPool::GetHeapAllocations()
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		return heapAllocations;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include "SimView.hpp"
+#include <algorithm>
+#include <vector>
+#include <immintrin.h>
+
+namespace SimView
+{
+	typedef void (*RowKernel)(Color* dst, const Color* src, int count);
+
+	// Blend equations follow Window::SetBlendMode, rounded to nearest like a UNORM8 framebuffer
+
+	static inline int Div255(int t)
+	{
+		t += 128;
+		return (t + (t >> 8)) >> 8;
+	}
+
+	Color Color::Blend(Color src, Color dst, BlendMode mode)
+	{
+		switch (mode)
+		{
+		case(BlendMode::Alpha):
+		{
+			int a = src.a;
+			return {
+				(unsigned char)Div255(src.r * a + dst.r * (255 - a)),
+				(unsigned char)Div255(src.g * a + dst.g * (255 - a)),
+				(unsigned char)Div255(src.b * a + dst.b * (255 - a)),
+				(unsigned char)Div255(src.a * a + dst.a * (255 - a)) };
+		}
+		case(BlendMode::PreMultAlpha):
+		{
+			int ia = 255 - src.a;
+			return {
+				(unsigned char)std::min(src.r + Div255(dst.r * ia), 255),
+				(unsigned char)std::min(src.g + Div255(dst.g * ia), 255),
+				(unsigned char)std::min(src.b + Div255(dst.b * ia), 255),
+				(unsigned char)std::min(src.a + Div255(dst.a * ia), 255) };
+		}
+		case(BlendMode::Add):
+			return {
+				(unsigned char)std::min(src.r + dst.r, 255),
+				(unsigned char)std::min(src.g + dst.g, 255),
+				(unsigned char)std::min(src.b + dst.b, 255),
+				(unsigned char)std::min(src.a + dst.a, 255) };
+		default:
+			return src;
+		}
+	}
+
+
+	// Scalar kernels
+
+	static void CopyRow_Scalar(Color* dst, const Color* src, int count)
+	{
+		for (int i = 0; i < count; i++)
+			dst[i] = src[i];
+	}
+
+	static void AlphaRow_Scalar(Color* dst, const Color* src, int count)
+	{
+		for (int i = 0; i < count; i++)
+			dst[i] = Color::Blend(src[i], dst[i], BlendMode::Alpha);
+	}
+
+	static void PreMultRow_Scalar(Color* dst, const Color* src, int count)
+	{
+		for (int i = 0; i < count; i++)
+			dst[i] = Color::Blend(src[i], dst[i], BlendMode::PreMultAlpha);
+	}
+
+	static void AddRow_Scalar(Color* dst, const Color* src, int count)
+	{
+		for (int i = 0; i < count; i++)
+			dst[i] = Color::Blend(src[i], dst[i], BlendMode::Add);
+	}
+
+
+	// SSE2 kernels, 4 pixels per register
+
+	static inline __m128i Div255_SSE2(__m128i t)
+	{
+		t = _mm_add_epi16(t, _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+	}
+
+	static inline __m128i SplatAlpha_SSE2(__m128i px16)
+	{
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	static inline __m128i Alpha_SSE2(__m128i s, __m128i d)
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i c255 = _mm_set1_epi16(255);
+		__m128i sLo = _mm_unpacklo_epi8(s, zero);
+		__m128i sHi = _mm_unpackhi_epi8(s, zero);
+		__m128i aLo = SplatAlpha_SSE2(sLo);
+		__m128i aHi = SplatAlpha_SSE2(sHi);
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(sLo, aLo), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(c255, aLo)));
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(sHi, aHi), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(c255, aHi)));
+		return _mm_packus_epi16(Div255_SSE2(lo), Div255_SSE2(hi));
+	}
+
+	static inline __m128i PreMult_SSE2(__m128i s, __m128i d)
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i c255 = _mm_set1_epi16(255);
+		__m128i iaLo = _mm_sub_epi16(c255, SplatAlpha_SSE2(_mm_unpacklo_epi8(s, zero)));
+		__m128i iaHi = _mm_sub_epi16(c255, SplatAlpha_SSE2(_mm_unpackhi_epi8(s, zero)));
+		__m128i lo = Div255_SSE2(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), iaLo));
+		__m128i hi = Div255_SSE2(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), iaHi));
+		return _mm_adds_epu8(s, _mm_packus_epi16(lo, hi));
+	}
+
+	static void CopyRow_SSE2(Color* dst, const Color* src, int count)
+	{
+		int i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(src + i + 4));
+			_mm_storeu_si128((__m128i*)(dst + i), a);
+			_mm_storeu_si128((__m128i*)(dst + i + 4), b);
+		}
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_loadu_si128((const __m128i*)(src + i)));
+		CopyRow_Scalar(dst + i, src + i, count - i);
+	}
+
+	static void AlphaRow_SSE2(Color* dst, const Color* src, int count)
+	{
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+			_mm_storeu_si128((__m128i*)(dst + i), Alpha_SSE2(s, d));
+		}
+		AlphaRow_Scalar(dst + i, src + i, count - i);
+	}
+
+	static void PreMultRow_SSE2(Color* dst, const Color* src, int count)
+	{
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+			_mm_storeu_si128((__m128i*)(dst + i), PreMult_SSE2(s, d));
+		}
+		PreMultRow_Scalar(dst + i, src + i, count - i);
+	}
+
+	static void AddRow_SSE2(Color* dst, const Color* src, int count)
+	{
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epu8(s, d));
+		}
+		AddRow_Scalar(dst + i, src + i, count - i);
+	}
+
+
+	// AVX2 kernels, 8 pixels per register
+
+	static inline __m256i Div255_AVX2(__m256i t)
+	{
+		t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+	}
+
+	static inline __m256i SplatAlpha_AVX2(__m256i px16)
+	{
+		return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	// unpack/pack operate per 128-bit lane, so pixel order is preserved end to end
+	static inline __m256i Alpha_AVX2(__m256i s, __m256i d)
+	{
+		__m256i zero = _mm256_setzero_si256();
+		__m256i c255 = _mm256_set1_epi16(255);
+		__m256i sLo = _mm256_unpacklo_epi8(s, zero);
+		__m256i sHi = _mm256_unpackhi_epi8(s, zero);
+		__m256i aLo = SplatAlpha_AVX2(sLo);
+		__m256i aHi = SplatAlpha_AVX2(sHi);
+		__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(sLo, aLo), _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(c255, aLo)));
+		__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(sHi, aHi), _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(c255, aHi)));
+		return _mm256_packus_epi16(Div255_AVX2(lo), Div255_AVX2(hi));
+	}
+
+	static inline __m256i PreMult_AVX2(__m256i s, __m256i d)
+	{
+		__m256i zero = _mm256_setzero_si256();
+		__m256i c255 = _mm256_set1_epi16(255);
+		__m256i iaLo = _mm256_sub_epi16(c255, SplatAlpha_AVX2(_mm256_unpacklo_epi8(s, zero)));
+		__m256i iaHi = _mm256_sub_epi16(c255, SplatAlpha_AVX2(_mm256_unpackhi_epi8(s, zero)));
+		__m256i lo = Div255_AVX2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), iaLo));
+		__m256i hi = Div255_AVX2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), iaHi));
+		return _mm256_adds_epu8(s, _mm256_packus_epi16(lo, hi));
+	}
+
+	static void CopyRow_AVX2(Color* dst, const Color* src, int count)
+	{
+		int i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m256i a = _mm256_loadu_si256((const __m256i*)(src + i));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(src + i + 8));
+			_mm256_storeu_si256((__m256i*)(dst + i), a);
+			_mm256_storeu_si256((__m256i*)(dst + i + 8), b);
+		}
+		for (; i + 8 <= count; i += 8)
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_loadu_si256((const __m256i*)(src + i)));
+		CopyRow_SSE2(dst + i, src + i, count - i);
+	}
+
+	static void AlphaRow_AVX2(Color* dst, const Color* src, int count)
+	{
+		int i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+			_mm256_storeu_si256((__m256i*)(dst + i), Alpha_AVX2(s, d));
+		}
+		AlphaRow_SSE2(dst + i, src + i, count - i);
+	}
+
+	static void PreMultRow_AVX2(Color* dst, const Color* src, int count)
+	{
+		int i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+			_mm256_storeu_si256((__m256i*)(dst + i), PreMult_AVX2(s, d));
+		}
+		PreMultRow_SSE2(dst + i, src + i, count - i);
+	}
+
+	static void AddRow_AVX2(Color* dst, const Color* src, int count)
+	{
+		int i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epu8(s, d));
+		}
+		AddRow_SSE2(dst + i, src + i, count - i);
+	}
+
+
+	static RowKernel SelectKernel(BlendMode mode)
+	{
+		static const RowKernel scalar[] = { CopyRow_Scalar, AlphaRow_Scalar, PreMultRow_Scalar, AddRow_Scalar };
+		static const RowKernel sse2[] = { CopyRow_SSE2, AlphaRow_SSE2, PreMultRow_SSE2, AddRow_SSE2 };
+		static const RowKernel avx2[] = { CopyRow_AVX2, AlphaRow_AVX2, PreMultRow_AVX2, AddRow_AVX2 };
+		static const RowKernel* table = Core::HasAVX2() ? avx2 : Core::HasSSE2() ? sse2 : scalar;
+		return table[(int)mode];
+	}
+
+	void BitmapView::DrawBitmap(int oX, int oY, const BitmapView& img)
+	{
+		DrawBitmap(oX, oY, img, BlendMode::Default);
+	}
+
+	void BitmapView::DrawBitmap(int oX, int oY, const BitmapView& img, BlendMode mode)
+	{
+		RowKernel kernel = SelectKernel(mode);
+
+		// Clip the destination rectangle against both views
+		int x0 = std::max(oX, 0);
+		int y0 = std::max(oY, 0);
+		int x1 = std::min(oX + img.width, width);
+		int y1 = std::min(oY + img.height, height);
+		if (x0 >= x1 || y0 >= y1)
+			return;
+
+		int count = x1 - x0;
+		const Color* srcBegin = img.data;
+		const Color* srcEnd = img.data + img.GetIndex(img.width, img.height - 1);
+		const Color* dstBegin = data;
+		const Color* dstEnd = data + GetIndex(width, height - 1);
+		if (srcBegin < dstEnd && dstBegin < srcEnd)
+		{
+			// Views may alias, stage each source row and walk rows in the order that reads sources before overwriting them
+			std::vector<Color> row(count);
+			bool bottomUp = img.data + img.GetIndex(0, y0 - oY) < data + GetIndex(0, y0);
+			for (int i = 0; i < y1 - y0; i++)
+			{
+				int y = bottomUp ? y1 - 1 - i : y0 + i;
+				std::copy_n(img.data + img.GetIndex(x0 - oX, y - oY), count, row.data());
+				kernel(data + GetIndex(x0, y), row.data(), count);
+			}
+			return;
+		}
+
+		for (int y = y0; y < y1; y++)
+			kernel(data + GetIndex(x0, y), img.data + img.GetIndex(x0 - oX, y - oY), count);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,332 @@
+#include "SimView.hpp"
+
+namespace SimView
+{
+	static size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	BufferHeap::BufferHeap(size_t blockSize, size_t alignment, GpuResourceType type)
+	{
+		if (blockSize == 0 || alignment == 0)
+			throw std::runtime_error("BufferHeap Error: Block size and alignment must be non-zero\n");
+		this->blockSize = blockSize;
+		this->alignment = alignment;
+		this->type = type;
+		this->self = std::make_shared<BufferHeap*>(this);
+	}
+
+	// Slices still held by arrays are detached, their buffers go away with the heap
+	BufferHeap::~BufferHeap()
+	{
+		*self = nullptr;
+		for (Block& block : blocks)
+		{
+			glDeleteBuffers(1, &block.buffer);
+		}
+	}
+
+	int BufferHeap::Allocate(size_t size, size_t alignment)
+	{
+		if (alignment == 0)
+			alignment = this->alignment;
+		size = std::max(size, size_t(1));
+
+		int block;
+		size_t offset;
+		if (!FindRange(size, alignment, int(blocks.size()) - 1, SIZE_MAX, block, offset))
+		{
+			block = AddBlock(size);
+			offset = 0;
+		}
+		TakeRange(blocks[block], offset, size);
+
+		int handle;
+		if (!freeHandles.empty())
+		{
+			handle = freeHandles.back();
+			freeHandles.pop_back();
+		}
+		else
+		{
+			handle = int(entries.size());
+			entries.push_back(Entry());
+		}
+		Entry& entry = entries[handle];
+		entry.slice = { blocks[block].buffer, offset, size };
+		entry.alignment = alignment;
+		entry.block = block;
+		blocks[block].slices[offset] = handle;
+		sliceCount++;
+		return handle;
+	}
+
+	void BufferHeap::Free(int handle)
+	{
+		if (handle < 0 || handle >= int(entries.size()) || entries[handle].block < 0)
+			throw std::runtime_error("BufferHeap Error: Invalid slice handle\n");
+
+		Entry& entry = entries[handle];
+		Block& block = blocks[entry.block];
+		block.slices.erase(entry.slice.offset);
+		ReleaseRange(block, entry.slice.offset, entry.slice.size);
+		entry = Entry();
+		freeHandles.push_back(handle);
+		sliceCount--;
+		TrimBlocks();
+	}
+
+	const BufferSlice& BufferHeap::GetSlice(int handle) const
+	{
+		if (handle < 0 || handle >= int(entries.size()) || entries[handle].block < 0)
+			throw std::runtime_error("BufferHeap Error: Invalid slice handle\n");
+		return entries[handle].slice;
+	}
+
+	void BufferHeap::Write(int handle, size_t offset, size_t size, const void* data)
+	{
+		const BufferSlice& slice = GetSlice(handle);
+		if (offset + size > slice.size)
+			throw std::runtime_error("BufferHeap Error: Write exceeds slice bounds\n");
+		glNamedBufferSubData(slice.buffer, slice.offset + offset, size, data);
+	}
+
+	// Moves slices into the lowest free range that fits, working back from the end of the heap.
+	// Moves are ordered in the GL command stream, so it can run between frames with a small budget;
+	// offsets change, so arrays must be rebound afterwards
+	size_t BufferHeap::Defragment(size_t maxBytes)
+	{
+		size_t moved = 0;
+		for (int b = int(blocks.size()) - 1; b >= 0; b--)
+		{
+			std::vector<int> handles;
+			for (auto it = blocks[b].slices.rbegin(); it != blocks[b].slices.rend(); ++it)
+			{
+				handles.push_back(it->second);
+			}
+
+			for (int handle : handles)
+			{
+				Entry& entry = entries[handle];
+				if (moved > 0 && moved + entry.slice.size > maxBytes)
+				{
+					TrimBlocks();
+					return moved;
+				}
+
+				int destBlock;
+				size_t destOffset;
+				if (!FindRange(entry.slice.size, entry.alignment, b, entry.slice.offset, destBlock, destOffset))
+					continue;
+
+				Block& source = blocks[b];
+				Block& dest = blocks[destBlock];
+				glCopyNamedBufferSubData(source.buffer, dest.buffer, entry.slice.offset, destOffset, entry.slice.size);
+
+				TakeRange(dest, destOffset, entry.slice.size);
+				source.slices.erase(entry.slice.offset);
+				ReleaseRange(source, entry.slice.offset, entry.slice.size);
+
+				entry.slice.buffer = dest.buffer;
+				entry.slice.offset = destOffset;
+				entry.block = destBlock;
+				dest.slices[destOffset] = handle;
+				moved += entry.slice.size;
+			}
+		}
+		TrimBlocks();
+		return moved;
+	}
+
+	void BufferHeap::SetLabel(std::string label)
+	{
+		this->label = label;
+		for (Block& block : blocks)
+		{
+			glObjectLabel(GL_BUFFER, block.buffer, -1, label.c_str());
+			block.allocation.SetLabel(label);
+		}
+	}
+
+	int BufferHeap::GetBlockCount() const
+	{
+		return int(blocks.size());
+	}
+
+	int BufferHeap::GetSliceCount() const
+	{
+		return sliceCount;
+	}
+
+	size_t BufferHeap::GetCapacity() const
+	{
+		size_t total = 0;
+		for (const Block& block : blocks)
+		{
+			total += block.size;
+		}
+		return total;
+	}
+
+	size_t BufferHeap::GetUsedBytes() const
+	{
+		size_t total = 0;
+		for (const Block& block : blocks)
+		{
+			total += block.used;
+		}
+		return total;
+	}
+
+	size_t BufferHeap::GetLargestFreeRange() const
+	{
+		size_t largest = 0;
+		for (const Block& block : blocks)
+		{
+			if (!block.freeBySize.empty())
+				largest = std::max(largest, block.freeBySize.rbegin()->first);
+		}
+		return largest;
+	}
+
+	// 0 when all free space is one range, approaching 1 as it splinters
+	float BufferHeap::GetFragmentation() const
+	{
+		size_t free = GetCapacity() - GetUsedBytes();
+		if (free == 0)
+			return 0.0f;
+		return 1.0f - float(GetLargestFreeRange()) / float(free);
+	}
+
+	int BufferHeap::AddBlock(size_t minSize)
+	{
+		Block block;
+		block.size = std::max(blockSize, AlignUp(minSize, alignment));
+		glCreateBuffers(1, &block.buffer);
+		glNamedBufferStorage(block.buffer, block.size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		if (!label.empty())
+			glObjectLabel(GL_BUFFER, block.buffer, -1, label.c_str());
+		block.allocation = GpuAllocation(type, block.size, label);
+		block.freeByOffset[0] = block.size;
+		block.freeBySize.insert({ block.size, 0 });
+		blocks.push_back(std::move(block));
+		return int(blocks.size()) - 1;
+	}
+
+	// Empty blocks are only released from the end, so block indices held by entries stay valid.
+	// One empty block is kept as a spare, so a slice going back and forth across a block
+	// boundary does not create and delete a whole block each time
+	void BufferHeap::TrimBlocks()
+	{
+		while (blocks.size() > 1 && blocks.back().used == 0 && blocks[blocks.size() - 2].used == 0)
+		{
+			glDeleteBuffers(1, &blocks.back().buffer);
+			blocks.pop_back();
+		}
+	}
+
+	// Best fit within each block, preferring lower blocks; in lastBlock the range must end at or before limit
+	bool BufferHeap::FindRange(size_t size, size_t alignment, int lastBlock, size_t limit, int& block, size_t& offset) const
+	{
+		for (int b = 0; b <= lastBlock; b++)
+		{
+			const Block& candidate = blocks[b];
+			for (auto it = candidate.freeBySize.lower_bound(size); it != candidate.freeBySize.end(); ++it)
+			{
+				size_t start = AlignUp(it->second, alignment);
+				size_t end = start + size;
+				if (end > it->second + it->first)
+					continue;
+				if (b == lastBlock && end > limit)
+					continue;
+
+				block = b;
+				offset = start;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void BufferHeap::TakeRange(Block& block, size_t offset, size_t size)
+	{
+		auto it = std::prev(block.freeByOffset.upper_bound(offset));
+		size_t rangeOffset = it->first;
+		size_t rangeSize = it->second;
+		EraseFree(block, rangeOffset, rangeSize);
+
+		if (offset > rangeOffset)
+		{
+			block.freeByOffset[rangeOffset] = offset - rangeOffset;
+			block.freeBySize.insert({ offset - rangeOffset, rangeOffset });
+		}
+		size_t end = offset + size;
+		if (end < rangeOffset + rangeSize)
+		{
+			block.freeByOffset[end] = rangeOffset + rangeSize - end;
+			block.freeBySize.insert({ rangeOffset + rangeSize - end, end });
+		}
+		block.used += size;
+	}
+
+	// Returns a range to the free lists, merging it with free neighbours on both sides
+	void BufferHeap::ReleaseRange(Block& block, size_t offset, size_t size)
+	{
+		block.used -= size;
+
+		auto next = block.freeByOffset.find(offset + size);
+		if (next != block.freeByOffset.end())
+		{
+			size += next->second;
+			EraseFree(block, next->first, next->second);
+		}
+
+		auto prev = block.freeByOffset.lower_bound(offset);
+		if (prev != block.freeByOffset.begin())
+		{
+			--prev;
+			if (prev->first + prev->second == offset)
+			{
+				offset = prev->first;
+				size += prev->second;
+				EraseFree(block, prev->first, prev->second);
+			}
+		}
+
+		block.freeByOffset[offset] = size;
+		block.freeBySize.insert({ size, offset });
+	}
+
+	void BufferHeap::EraseFree(Block& block, size_t offset, size_t size)
+	{
+		block.freeByOffset.erase(offset);
+		auto range = block.freeBySize.equal_range(size);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (it->second == offset)
+			{
+				block.freeBySize.erase(it);
+				break;
+			}
+		}
+	}
+
+	HeapRef BufferHeap::GetRef() const
+	{
+		return HeapRef(self);
+	}
+
+	BufferHeap* HeapRef::Get() const
+	{
+		if (cell == nullptr || *cell == nullptr)
+			throw std::runtime_error("BufferHeap Error: Slice used after its heap was destroyed\n");
+		return *cell;
+	}
+
+	void HeapRef::Free(int slice) const
+	{
+		if (cell != nullptr && *cell != nullptr)
+			(*cell)->Free(slice);
+	}
+}
\ No newline at end of file
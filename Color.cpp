@@ -0,0 +1,286 @@
+#include "SimView.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <immintrin.h>
+
+namespace SimView
+{
+	// Lookup tables, built once on first use
+
+	struct SrgbTables
+	{
+		std::array<float, 256> toLinearFloat;
+		std::array<unsigned char, 256> toLinear;
+		std::array<unsigned char, 256> toSrgb;
+		std::array<unsigned char, 4096> floatToSrgb;
+		std::array<unsigned int, 256> unpremultiply;
+	};
+
+	static float SrgbDecode(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static float SrgbEncode(float c)
+	{
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+	}
+
+	static const SrgbTables& GetTables()
+	{
+		static const SrgbTables tables = []
+		{
+			SrgbTables t;
+			for (int i = 0; i < 256; i++)
+			{
+				t.toLinearFloat[i] = SrgbDecode(i / 255.f);
+				t.toLinear[i] = (unsigned char)std::lround(t.toLinearFloat[i] * 255.f);
+				t.toSrgb[i] = (unsigned char)std::lround(SrgbEncode(i / 255.f) * 255.f);
+				t.unpremultiply[i] = i == 0 ? 0 : (255u * 65536u + i / 2) / i;
+			}
+			for (int i = 0; i < 4096; i++)
+				t.floatToSrgb[i] = (unsigned char)std::lround(SrgbEncode(i / 4095.f) * 255.f);
+			return t;
+		}();
+		return tables;
+	}
+
+
+	// Color to FColor
+
+	static void ToFloat_Scalar(const Color* src, FColor* dst, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			dst[i] = FColor::Convert(src[i]);
+	}
+
+	static void ToFloat_SSE2(const Color* src, FColor* dst, size_t count)
+	{
+		__m128 scale = _mm_set1_ps(1.f / 255.f);
+		__m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i px = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i lo = _mm_unpacklo_epi8(px, zero);
+			__m128i hi = _mm_unpackhi_epi8(px, zero);
+			float* out = &dst[i].r;
+			_mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+			_mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+			_mm_storeu_ps(out + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+			_mm_storeu_ps(out + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+		}
+		ToFloat_Scalar(src + i, dst + i, count - i);
+	}
+
+	static void ToFloat_AVX2(const Color* src, FColor* dst, size_t count)
+	{
+		__m256 scale = _mm256_set1_ps(1.f / 255.f);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i px = _mm_loadu_si128((const __m128i*)(src + i));
+			float* out = &dst[i].r;
+			_mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(px)), scale));
+			_mm256_storeu_ps(out + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(px, 8))), scale));
+		}
+		ToFloat_Scalar(src + i, dst + i, count - i);
+	}
+
+	void FColor::ConvertArray(const Color* src, FColor* dst, size_t count)
+	{
+		if (Core::HasAVX2())
+			ToFloat_AVX2(src, dst, count);
+		else if (Core::HasSSE2())
+			ToFloat_SSE2(src, dst, count);
+		else
+			ToFloat_Scalar(src, dst, count);
+	}
+
+	void FColor::ConvertSrgbArray(const Color* src, FColor* dst, size_t count)
+	{
+		const SrgbTables& tables = GetTables();
+		const float scale = 1.f / 255.f;
+		for (size_t i = 0; i < count; i++)
+			dst[i] = { tables.toLinearFloat[src[i].r], tables.toLinearFloat[src[i].g], tables.toLinearFloat[src[i].b], src[i].a * scale };
+	}
+
+
+	// FColor to Color
+
+	static inline unsigned char ToByte(float value)
+	{
+		return (unsigned char)std::lround(std::clamp(value, 0.f, 1.f) * 255.f);
+	}
+
+	static void ToByte_Scalar(const FColor* src, Color* dst, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			dst[i] = { ToByte(src[i].r), ToByte(src[i].g), ToByte(src[i].b), ToByte(src[i].a) };
+	}
+
+	static void ToByte_SSE2(const FColor* src, Color* dst, size_t count)
+	{
+		__m128 scale = _mm_set1_ps(255.f);
+		__m128 zero = _mm_setzero_ps();
+		__m128 one = _mm_set1_ps(1.f);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float* in = &src[i].r;
+			__m128i p0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in), zero), one), scale));
+			__m128i p1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + 4), zero), one), scale));
+			__m128i p2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + 8), zero), one), scale));
+			__m128i p3 = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + 12), zero), one), scale));
+			__m128i packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+			_mm_storeu_si128((__m128i*)(dst + i), packed);
+		}
+		ToByte_Scalar(src + i, dst + i, count - i);
+	}
+
+	static void ToByte_AVX2(const FColor* src, Color* dst, size_t count)
+	{
+		__m256 scale = _mm256_set1_ps(255.f);
+		__m256 zero = _mm256_setzero_ps();
+		__m256 one = _mm256_set1_ps(1.f);
+		__m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const float* in = &src[i].r;
+			__m256i p01 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in), zero), one), scale));
+			__m256i p23 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + 8), zero), one), scale));
+			__m256i p45 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + 16), zero), one), scale));
+			__m256i p67 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + 24), zero), one), scale));
+
+			// Packs work per 128-bit lane, leaving even pixels in the low lane and odd ones in the high lane
+			__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(p01, p23), _mm256_packs_epi32(p45, p67));
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_permutevar8x32_epi32(packed, order));
+		}
+		ToByte_SSE2(src + i, dst + i, count - i);
+	}
+
+	void Color::ConvertArray(const FColor* src, Color* dst, size_t count)
+	{
+		if (Core::HasAVX2())
+			ToByte_AVX2(src, dst, count);
+		else if (Core::HasSSE2())
+			ToByte_SSE2(src, dst, count);
+		else
+			ToByte_Scalar(src, dst, count);
+	}
+
+	void Color::ConvertSrgbArray(const FColor* src, Color* dst, size_t count)
+	{
+		const SrgbTables& tables = GetTables();
+		auto encode = [&](float value) { return tables.floatToSrgb[std::lround(std::clamp(value, 0.f, 1.f) * 4095.f)]; };
+		for (size_t i = 0; i < count; i++)
+			dst[i] = { encode(src[i].r), encode(src[i].g), encode(src[i].b), ToByte(src[i].a) };
+	}
+
+	void Color::SrgbToLinear(const Color* src, Color* dst, size_t count)
+	{
+		const SrgbTables& tables = GetTables();
+		for (size_t i = 0; i < count; i++)
+			dst[i] = { tables.toLinear[src[i].r], tables.toLinear[src[i].g], tables.toLinear[src[i].b], src[i].a };
+	}
+
+	void Color::LinearToSrgb(const Color* src, Color* dst, size_t count)
+	{
+		const SrgbTables& tables = GetTables();
+		for (size_t i = 0; i < count; i++)
+			dst[i] = { tables.toSrgb[src[i].r], tables.toSrgb[src[i].g], tables.toSrgb[src[i].b], src[i].a };
+	}
+
+
+	// Premultiplication
+
+	static inline int Div255(int t)
+	{
+		t += 128;
+		return (t + (t >> 8)) >> 8;
+	}
+
+	static void Premultiply_Scalar(Color* data, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			int a = data[i].a;
+			data[i] = { (unsigned char)Div255(data[i].r * a), (unsigned char)Div255(data[i].g * a), (unsigned char)Div255(data[i].b * a), data[i].a };
+		}
+	}
+
+	static void Premultiply_SSE2(Color* data, size_t count)
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i bias = _mm_set1_epi16(128);
+		// Alpha is multiplied by 255 so it survives the divide unchanged
+		__m128i rgbMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+		__m128i alpha255 = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+		auto premult = [&](__m128i px16)
+		{
+			__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m128i factor = _mm_or_si128(_mm_and_si128(a, rgbMask), alpha255);
+			__m128i t = _mm_add_epi16(_mm_mullo_epi16(px16, factor), bias);
+			return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+		};
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i px = _mm_loadu_si128((const __m128i*)(data + i));
+			__m128i lo = premult(_mm_unpacklo_epi8(px, zero));
+			__m128i hi = premult(_mm_unpackhi_epi8(px, zero));
+			_mm_storeu_si128((__m128i*)(data + i), _mm_packus_epi16(lo, hi));
+		}
+		Premultiply_Scalar(data + i, count - i);
+	}
+
+	static void Premultiply_AVX2(Color* data, size_t count)
+	{
+		__m256i zero = _mm256_setzero_si256();
+		__m256i bias = _mm256_set1_epi16(128);
+		__m256i rgbMask = _mm256_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0);
+		__m256i alpha255 = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+		auto premult = [&](__m256i px16)
+		{
+			__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m256i factor = _mm256_or_si256(_mm256_and_si256(a, rgbMask), alpha255);
+			__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(px16, factor), bias);
+			return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+		};
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i px = _mm256_loadu_si256((const __m256i*)(data + i));
+			__m256i lo = premult(_mm256_unpacklo_epi8(px, zero));
+			__m256i hi = premult(_mm256_unpackhi_epi8(px, zero));
+			_mm256_storeu_si256((__m256i*)(data + i), _mm256_packus_epi16(lo, hi));
+		}
+		Premultiply_SSE2(data + i, count - i);
+	}
+
+	void Color::Premultiply(Color* data, size_t count)
+	{
+		if (Core::HasAVX2())
+			Premultiply_AVX2(data, count);
+		else if (Core::HasSSE2())
+			Premultiply_SSE2(data, count);
+		else
+			Premultiply_Scalar(data, count);
+	}
+
+	void Color::Unpremultiply(Color* data, size_t count)
+	{
+		// Fixed point reciprocal of alpha from a table, one multiply and shift per channel
+		const SrgbTables& tables = GetTables();
+		for (size_t i = 0; i < count; i++)
+		{
+			unsigned int recip = tables.unpremultiply[data[i].a];
+			auto channel = [&](unsigned char c) { return (unsigned char)std::min((c * recip + 32768u) >> 16, 255u); };
+			data[i] = { channel(data[i].r), channel(data[i].g), channel(data[i].b), data[i].a };
+		}
+	}
+}
\ No newline at end of file
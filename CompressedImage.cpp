@@ -0,0 +1,749 @@
+#include "SimView.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace SimView
+{
+	// Shared block helpers
+
+	static void FetchBlock(const Bitmap& image, int blockX, int blockY, Color* block)
+	{
+		// Edge blocks repeat the last row and column
+		for (int y = 0; y < 4; y++)
+		{
+			int srcY = std::min(blockY * 4 + y, image.height - 1);
+			for (int x = 0; x < 4; x++)
+			{
+				int srcX = std::min(blockX * 4 + x, image.width - 1);
+				block[y * 4 + x] = image.data[size_t(srcY) * image.width + srcX];
+			}
+		}
+	}
+
+	static void StoreBlock(Bitmap& image, int blockX, int blockY, const Color* block)
+	{
+		for (int y = 0; y < 4 && blockY * 4 + y < image.height; y++)
+		{
+			for (int x = 0; x < 4 && blockX * 4 + x < image.width; x++)
+				image.data[size_t(blockY * 4 + y) * image.width + blockX * 4 + x] = block[y * 4 + x];
+		}
+	}
+
+	// Principal axis of the block by power iteration on the covariance matrix
+	template <int N>
+	static void PrincipalAxis(const float (*points)[4], int count, float* mean, float* axis)
+	{
+		for (int c = 0; c < N; c++)
+			mean[c] = 0;
+		for (int i = 0; i < count; i++)
+			for (int c = 0; c < N; c++)
+				mean[c] += points[i][c];
+		for (int c = 0; c < N; c++)
+			mean[c] /= count;
+
+		float cov[N][N] = {};
+		for (int i = 0; i < count; i++)
+			for (int a = 0; a < N; a++)
+				for (int b = 0; b < N; b++)
+					cov[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+
+		for (int c = 0; c < N; c++)
+			axis[c] = 1;
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[N] = {};
+			for (int a = 0; a < N; a++)
+				for (int b = 0; b < N; b++)
+					next[a] += cov[a][b] * axis[b];
+			float length = 0;
+			for (int c = 0; c < N; c++)
+				length = std::max(length, std::abs(next[c]));
+			if (length == 0)
+				return;
+			for (int c = 0; c < N; c++)
+				axis[c] = next[c] / length;
+		}
+	}
+
+	template <int N>
+	static void AxisEndpoints(const float (*points)[4], int count, float* low, float* high)
+	{
+		float mean[4], axis[4];
+		PrincipalAxis<N>(points, count, mean, axis);
+
+		float minT = std::numeric_limits<float>::max();
+		float maxT = -std::numeric_limits<float>::max();
+		for (int i = 0; i < count; i++)
+		{
+			float t = 0;
+			for (int c = 0; c < N; c++)
+				t += (points[i][c] - mean[c]) * axis[c];
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		float lengthSq = 0;
+		for (int c = 0; c < N; c++)
+			lengthSq += axis[c] * axis[c];
+		if (lengthSq == 0)
+			lengthSq = 1;
+		for (int c = 0; c < N; c++)
+		{
+			low[c] = std::clamp(mean[c] + axis[c] * minT / lengthSq, 0.0f, 255.0f);
+			high[c] = std::clamp(mean[c] + axis[c] * maxT / lengthSq, 0.0f, 255.0f);
+		}
+	}
+
+	// Least squares fit of both endpoints to the current index assignment
+	template <int N>
+	static bool FitEndpoints(const float (*points)[4], const float* weights, int count, float* low, float* high)
+	{
+		float aa = 0, ab = 0, bb = 0;
+		float ax[4] = {}, bx[4] = {};
+		for (int i = 0; i < count; i++)
+		{
+			float b = weights[i];
+			float a = 1 - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < N; c++)
+			{
+				ax[c] += a * points[i][c];
+				bx[c] += b * points[i][c];
+			}
+		}
+
+		float det = aa * bb - ab * ab;
+		if (std::abs(det) < 1e-6f)
+			return false;
+		for (int c = 0; c < N; c++)
+		{
+			low[c] = std::clamp((bb * ax[c] - ab * bx[c]) / det, 0.0f, 255.0f);
+			high[c] = std::clamp((aa * bx[c] - ab * ax[c]) / det, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	static int Iterations(CompressionQuality quality)
+	{
+		switch (quality)
+		{
+		case CompressionQuality::Fast:
+			return 0;
+		case CompressionQuality::Normal:
+			return 1;
+		default:
+			return 4;
+		}
+	}
+
+	// BC1 color block
+
+	static std::uint16_t Pack565(const float* color)
+	{
+		int r = (int)std::lround(color[0] * 31 / 255);
+		int g = (int)std::lround(color[1] * 63 / 255);
+		int b = (int)std::lround(color[2] * 31 / 255);
+		return (std::uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	static void Unpack565(std::uint16_t packed, int* color)
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	static void ColorPalette(std::uint16_t c0, std::uint16_t c1, bool fourColor, int (*palette)[4])
+	{
+		Unpack565(c0, palette[0]);
+		Unpack565(c1, palette[1]);
+		palette[0][3] = palette[1][3] = 255;
+		for (int c = 0; c < 3; c++)
+		{
+			if (fourColor)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = fourColor ? 255 : 0;
+	}
+
+	// Picks indices for every point, returns the squared error
+	static int ColorIndices(const Color* block, const bool* transparent, int (*palette)[4], int paletteSize, unsigned char* indices)
+	{
+		int total = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			if (transparent != nullptr && transparent[i])
+			{
+				indices[i] = 3;
+				continue;
+			}
+			int best = 0;
+			int bestError = INT_MAX;
+			for (int p = 0; p < paletteSize; p++)
+			{
+				int dr = block[i].r - palette[p][0];
+				int dg = block[i].g - palette[p][1];
+				int db = block[i].b - palette[p][2];
+				int error = dr * dr + dg * dg + db * db;
+				if (error < bestError)
+				{
+					bestError = error;
+					best = p;
+				}
+			}
+			indices[i] = (unsigned char)best;
+			total += bestError;
+		}
+		return total;
+	}
+
+	static void EncodeColorBlock(const Color* block, bool allowAlpha, CompressionQuality quality, unsigned char* out)
+	{
+		// BC1 punch-through alpha uses the three color mode with index 3 as transparent black
+		bool transparent[16];
+		bool anyTransparent = false;
+		float points[16][4];
+		int count = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			transparent[i] = allowAlpha && block[i].a < 128;
+			anyTransparent |= transparent[i];
+			if (!transparent[i])
+			{
+				points[count][0] = block[i].r;
+				points[count][1] = block[i].g;
+				points[count][2] = block[i].b;
+				count++;
+			}
+		}
+
+		std::uint16_t c0 = 0, c1 = 0;
+		unsigned char indices[16];
+		std::memset(indices, 3, sizeof(indices));
+		if (count > 0)
+		{
+			bool fourColor = !anyTransparent;
+			int paletteSize = fourColor ? 4 : 3;
+			float low[4], high[4];
+			AxisEndpoints<3>(points, count, low, high);
+			c0 = Pack565(high);
+			c1 = Pack565(low);
+
+			int palette[4][4];
+			ColorPalette(c0, c1, fourColor, palette);
+			int error = ColorIndices(block, anyTransparent ? transparent : nullptr, palette, paletteSize, indices);
+
+			// Index to interpolation weight towards c1
+			static const float fourWeights[4] = { 0.0f, 1.0f, 1.0f / 3, 2.0f / 3 };
+			static const float threeWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+			const float* toWeight = fourColor ? fourWeights : threeWeights;
+
+			for (int iteration = 0; iteration < Iterations(quality) && error > 0; iteration++)
+			{
+				float weights[16];
+				for (int i = 0, n = 0; i < 16; i++)
+					if (!transparent[i])
+						weights[n++] = toWeight[indices[i]];
+				if (!FitEndpoints<3>(points, weights, count, high, low))
+					break;
+
+				std::uint16_t n0 = Pack565(high);
+				std::uint16_t n1 = Pack565(low);
+				unsigned char nextIndices[16];
+				ColorPalette(n0, n1, fourColor, palette);
+				int nextError = ColorIndices(block, anyTransparent ? transparent : nullptr, palette, paletteSize, nextIndices);
+				if (nextError >= error)
+					break;
+				c0 = n0;
+				c1 = n1;
+				error = nextError;
+				std::memcpy(indices, nextIndices, sizeof(indices));
+			}
+
+			// Endpoint order selects the mode, swapping endpoints exchanges indices 0 and 1 and in four color mode 2 and 3
+			if ((fourColor && c0 < c1) || (!fourColor && c0 > c1))
+			{
+				std::swap(c0, c1);
+				for (int i = 0; i < 16; i++)
+				{
+					if (indices[i] < 2)
+						indices[i] ^= 1;
+					else if (fourColor)
+						indices[i] ^= 1;
+				}
+			}
+			if (fourColor && c0 == c1)
+				std::memset(indices, 0, sizeof(indices));
+		}
+
+		std::uint32_t bits = 0;
+		for (int i = 0; i < 16; i++)
+			bits |= std::uint32_t(indices[i]) << (i * 2);
+		out[0] = c0 & 0xFF;
+		out[1] = c0 >> 8;
+		out[2] = c1 & 0xFF;
+		out[3] = c1 >> 8;
+		std::memcpy(out + 4, &bits, 4);
+	}
+
+	static void DecodeColorBlock(const unsigned char* in, bool alwaysFourColor, Color* block)
+	{
+		std::uint16_t c0 = in[0] | (in[1] << 8);
+		std::uint16_t c1 = in[2] | (in[3] << 8);
+		std::uint32_t bits;
+		std::memcpy(&bits, in + 4, 4);
+
+		int palette[4][4];
+		ColorPalette(c0, c1, alwaysFourColor || c0 > c1, palette);
+		for (int i = 0; i < 16; i++)
+		{
+			const int* color = palette[(bits >> (i * 2)) & 3];
+			block[i] = { (unsigned char)color[0], (unsigned char)color[1], (unsigned char)color[2], (unsigned char)color[3] };
+		}
+	}
+
+	// BC3 alpha block
+
+	static void AlphaPalette(int a0, int a1, int* palette)
+	{
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1)
+		{
+			for (int i = 1; i < 7; i++)
+				palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+		}
+		else
+		{
+			for (int i = 1; i < 5; i++)
+				palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	static int AlphaIndices(const Color* block, int a0, int a1, unsigned char* indices)
+	{
+		int palette[8];
+		AlphaPalette(a0, a1, palette);
+		int total = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			int bestError = INT_MAX;
+			for (int p = 0; p < 8; p++)
+			{
+				int error = std::abs(block[i].a - palette[p]);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = p;
+				}
+			}
+			indices[i] = (unsigned char)best;
+			total += bestError * bestError;
+		}
+		return total;
+	}
+
+	static void EncodeAlphaBlock(const Color* block, CompressionQuality quality, unsigned char* out)
+	{
+		int minA = 255, maxA = 0;
+		int minInner = 255, maxInner = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			minA = std::min<int>(minA, block[i].a);
+			maxA = std::max<int>(maxA, block[i].a);
+			if (block[i].a != 0 && block[i].a != 255)
+			{
+				minInner = std::min<int>(minInner, block[i].a);
+				maxInner = std::max<int>(maxInner, block[i].a);
+			}
+		}
+
+		int a0 = maxA, a1 = minA;
+		unsigned char indices[16];
+		int error = AlphaIndices(block, a0, a1, indices);
+
+		// The six value mode keeps exact 0 and 255, which helps blocks mixing cutout edges with soft alpha
+		if (quality != CompressionQuality::Fast && error > 0 && minInner <= maxInner && minInner != maxInner)
+		{
+			unsigned char innerIndices[16];
+			int innerError = AlphaIndices(block, minInner, maxInner, innerIndices);
+			if (innerError < error)
+			{
+				a0 = minInner;
+				a1 = maxInner;
+				std::memcpy(indices, innerIndices, sizeof(indices));
+			}
+		}
+
+		std::uint64_t bits = 0;
+		for (int i = 0; i < 16; i++)
+			bits |= std::uint64_t(indices[i]) << (i * 3);
+		out[0] = (unsigned char)a0;
+		out[1] = (unsigned char)a1;
+		for (int i = 0; i < 6; i++)
+			out[2 + i] = (unsigned char)(bits >> (i * 8));
+	}
+
+	static void DecodeAlphaBlock(const unsigned char* in, Color* block)
+	{
+		int palette[8];
+		AlphaPalette(in[0], in[1], palette);
+		std::uint64_t bits = 0;
+		for (int i = 0; i < 6; i++)
+			bits |= std::uint64_t(in[2 + i]) << (i * 8);
+		for (int i = 0; i < 16; i++)
+			block[i].a = (unsigned char)palette[(bits >> (i * 3)) & 7];
+	}
+
+	// BC7 mode 6, a single RGBA subset with 7 bit endpoints, a p-bit each and 4 bit indices
+
+	static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	static void QuantizeMode6(const float* color, int pBit, int* quantized)
+	{
+		for (int c = 0; c < 4; c++)
+			quantized[c] = std::clamp((int)std::lround((color[c] - pBit) / 2), 0, 127);
+	}
+
+	static int Mode6Indices(const Color* block, const int* q0, int p0, const int* q1, int p1, unsigned char* indices)
+	{
+		int e0[4], e1[4];
+		for (int c = 0; c < 4; c++)
+		{
+			e0[c] = (q0[c] << 1) | p0;
+			e1[c] = (q1[c] << 1) | p1;
+		}
+		int palette[16][4];
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 4; c++)
+				palette[i][c] = ((64 - bc7Weights[i]) * e0[c] + bc7Weights[i] * e1[c] + 32) >> 6;
+
+		int total = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			const unsigned char* pixel = &block[i].r;
+			int best = 0;
+			int bestError = INT_MAX;
+			for (int p = 0; p < 16; p++)
+			{
+				int error = 0;
+				for (int c = 0; c < 4; c++)
+					error += (pixel[c] - palette[p][c]) * (pixel[c] - palette[p][c]);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = p;
+				}
+			}
+			indices[i] = (unsigned char)best;
+			total += bestError;
+		}
+		return total;
+	}
+
+	struct Mode6Block
+	{
+		int q0[4], q1[4];
+		int p0, p1;
+		unsigned char indices[16];
+		int error;
+	};
+
+	static void QuantizeEndpoints(const Color* block, const float* low, const float* high, CompressionQuality quality, Mode6Block& result)
+	{
+		// Fast and normal quality pick each p-bit on its own, high tries every combination
+		result.error = INT_MAX;
+		for (int p0 = 0; p0 < 2; p0++)
+		{
+			for (int p1 = 0; p1 < 2; p1++)
+			{
+				if (quality != CompressionQuality::High && p0 != p1)
+					continue;
+				Mode6Block candidate;
+				candidate.p0 = p0;
+				candidate.p1 = p1;
+				QuantizeMode6(low, p0, candidate.q0);
+				QuantizeMode6(high, p1, candidate.q1);
+				candidate.error = Mode6Indices(block, candidate.q0, p0, candidate.q1, p1, candidate.indices);
+				if (candidate.error < result.error)
+					result = candidate;
+			}
+		}
+	}
+
+	static void WriteBits(unsigned char* out, int& position, std::uint32_t value, int count)
+	{
+		for (int i = 0; i < count; i++, position++)
+			if ((value >> i) & 1)
+				out[position >> 3] |= 1 << (position & 7);
+	}
+
+	static std::uint32_t ReadBits(const unsigned char* in, int& position, int count)
+	{
+		std::uint32_t value = 0;
+		for (int i = 0; i < count; i++, position++)
+			value |= std::uint32_t((in[position >> 3] >> (position & 7)) & 1) << i;
+		return value;
+	}
+
+	static void EncodeBC7Block(const Color* block, CompressionQuality quality, unsigned char* out)
+	{
+		float points[16][4];
+		for (int i = 0; i < 16; i++)
+		{
+			points[i][0] = block[i].r;
+			points[i][1] = block[i].g;
+			points[i][2] = block[i].b;
+			points[i][3] = block[i].a;
+		}
+
+		float low[4], high[4];
+		AxisEndpoints<4>(points, 16, low, high);
+		Mode6Block result;
+		QuantizeEndpoints(block, low, high, quality, result);
+
+		for (int iteration = 0; iteration < Iterations(quality) && result.error > 0; iteration++)
+		{
+			float weights[16];
+			for (int i = 0; i < 16; i++)
+				weights[i] = bc7Weights[result.indices[i]] / 64.0f;
+			if (!FitEndpoints<4>(points, weights, 16, low, high))
+				break;
+
+			Mode6Block next;
+			QuantizeEndpoints(block, low, high, quality, next);
+			if (next.error >= result.error)
+				break;
+			result = next;
+		}
+
+		// The anchor index is stored with its top bit implied zero
+		if (result.indices[0] & 8)
+		{
+			std::swap(result.q0, result.q1);
+			std::swap(result.p0, result.p1);
+			for (int i = 0; i < 16; i++)
+				result.indices[i] = 15 - result.indices[i];
+		}
+
+		std::memset(out, 0, 16);
+		int position = 0;
+		WriteBits(out, position, 1 << 6, 7);
+		for (int c = 0; c < 4; c++)
+		{
+			WriteBits(out, position, result.q0[c], 7);
+			WriteBits(out, position, result.q1[c], 7);
+		}
+		WriteBits(out, position, result.p0, 1);
+		WriteBits(out, position, result.p1, 1);
+		WriteBits(out, position, result.indices[0], 3);
+		for (int i = 1; i < 16; i++)
+			WriteBits(out, position, result.indices[i], 4);
+	}
+
+	static void DecodeBC7Block(const unsigned char* in, Color* block)
+	{
+		int position = 0;
+		if (ReadBits(in, position, 7) != (1 << 6))
+			throw std::runtime_error("CompressedImage Error: Only BC7 mode 6 blocks can be decoded\n");
+
+		int e0[4], e1[4];
+		for (int c = 0; c < 4; c++)
+		{
+			e0[c] = ReadBits(in, position, 7) << 1;
+			e1[c] = ReadBits(in, position, 7) << 1;
+		}
+		int p0 = ReadBits(in, position, 1);
+		int p1 = ReadBits(in, position, 1);
+		for (int c = 0; c < 4; c++)
+		{
+			e0[c] |= p0;
+			e1[c] |= p1;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			int weight = bc7Weights[ReadBits(in, position, i == 0 ? 3 : 4)];
+			unsigned char* pixel = &block[i].r;
+			for (int c = 0; c < 4; c++)
+				pixel[c] = (unsigned char)(((64 - weight) * e0[c] + weight * e1[c] + 32) >> 6);
+		}
+	}
+
+	// CompressedImage
+
+	GLenum CompressedImage::GetInternalFormat(BlockFormat format)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		case BlockFormat::BC3:
+			return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		default:
+			return GL_COMPRESSED_RGBA_BPTC_UNORM;
+		}
+	}
+
+	GLenum CompressedImage::GetInternalFormat() const
+	{
+		return GetInternalFormat(format);
+	}
+
+	int CompressedImage::GetBlockBytes(BlockFormat format)
+	{
+		return format == BlockFormat::BC1 ? 8 : 16;
+	}
+
+	size_t CompressedImage::GetLevelSize(BlockFormat format, int width, int height)
+	{
+		return size_t((width + 3) / 4) * ((height + 3) / 4) * GetBlockBytes(format);
+	}
+
+	std::vector<unsigned char> CompressedImage::EncodeLevel(const Bitmap& image, BlockFormat format, CompressionQuality quality, ThreadPool& pool)
+	{
+		if (image.format != PixelFormat::RGBA8)
+			throw std::runtime_error("CompressedImage Error: Only RGBA8 bitmaps can be block compressed\n");
+
+		int blocksX = (image.width + 3) / 4;
+		int blocksY = (image.height + 3) / 4;
+		int blockBytes = GetBlockBytes(format);
+		std::vector<unsigned char> data(GetLevelSize(format, image.width, image.height));
+
+		// Blocks are independent, each task encodes one row of them
+		pool.ParallelFor(blocksY, [&](int blockY)
+		{
+			Color block[16];
+			for (int blockX = 0; blockX < blocksX; blockX++)
+			{
+				unsigned char* out = data.data() + (size_t(blockY) * blocksX + blockX) * blockBytes;
+				FetchBlock(image, blockX, blockY, block);
+				switch (format)
+				{
+				case BlockFormat::BC1:
+					EncodeColorBlock(block, true, quality, out);
+					break;
+				case BlockFormat::BC3:
+					EncodeAlphaBlock(block, quality, out);
+					EncodeColorBlock(block, false, quality, out + 8);
+					break;
+				case BlockFormat::BC7:
+					EncodeBC7Block(block, quality, out);
+					break;
+				}
+			}
+		});
+		return data;
+	}
+
+	CompressedImage CompressedImage::Encode(const Bitmap& image, BlockFormat format, CompressionQuality quality, bool mipmaps, CompressionStats* stats, ThreadPool& pool)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		CompressedImage result;
+		result.format = format;
+		result.width = image.width;
+		result.height = image.height;
+		result.levels.push_back(EncodeLevel(image, format, quality, pool));
+		if (mipmaps)
+		{
+			std::vector<Bitmap> mips = image.GenMipChain(ResampleFilter::Box, pool);
+			for (const Bitmap& mip : mips)
+				result.levels.push_back(EncodeLevel(mip, format, quality, pool));
+		}
+
+		if (stats != nullptr)
+		{
+			stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			stats->inputBytes = image.GetByteSize();
+			stats->outputBytes = result.levels[0].size();
+			stats->psnr = ComputePsnr(image, result.Decode(0));
+		}
+		return result;
+	}
+
+	Bitmap CompressedImage::DecodeLevel(const unsigned char* data, int width, int height, BlockFormat format)
+	{
+		Bitmap image(width, height);
+		int blocksX = (width + 3) / 4;
+		int blocksY = (height + 3) / 4;
+		int blockBytes = GetBlockBytes(format);
+
+		Color block[16];
+		for (int blockY = 0; blockY < blocksY; blockY++)
+		{
+			for (int blockX = 0; blockX < blocksX; blockX++)
+			{
+				const unsigned char* in = data + (size_t(blockY) * blocksX + blockX) * blockBytes;
+				switch (format)
+				{
+				case BlockFormat::BC1:
+					DecodeColorBlock(in, false, block);
+					break;
+				case BlockFormat::BC3:
+					DecodeColorBlock(in + 8, true, block);
+					DecodeAlphaBlock(in, block);
+					break;
+				case BlockFormat::BC7:
+					DecodeBC7Block(in, block);
+					break;
+				}
+				StoreBlock(image, blockX, blockY, block);
+			}
+		}
+		return image;
+	}
+
+	Bitmap CompressedImage::Decode(int level) const
+	{
+		int levelWidth = std::max(width >> level, 1);
+		int levelHeight = std::max(height >> level, 1);
+		return DecodeLevel(levels[level].data(), levelWidth, levelHeight, format);
+	}
+
+	double CompressedImage::ComputePsnr(const Bitmap& a, const Bitmap& b)
+	{
+		if (a.width != b.width || a.height != b.height || a.format != PixelFormat::RGBA8 || b.format != PixelFormat::RGBA8)
+			throw std::runtime_error("CompressedImage Error: PSNR needs two RGBA8 bitmaps of the same size\n");
+
+		const unsigned char* pa = (const unsigned char*)a.data;
+		const unsigned char* pb = (const unsigned char*)b.data;
+		size_t count = size_t(a.width) * a.height * 4;
+		double sum = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			double diff = double(pa[i]) - pb[i];
+			sum += diff * diff;
+		}
+		if (sum == 0)
+			return std::numeric_limits<double>::infinity();
+		double mse = sum / count;
+		return 10 * std::log10(255.0 * 255.0 / mse);
+	}
+}
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include "SimView.hpp"
 #include <print>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 namespace SimView
 {
@@ -8,6 +14,50 @@ namespace SimView
         std::println(stderr, "GLFW Error: {}\n", description);
     }
 
+    static void cpuid(int info[4], int leaf, int subleaf)
+    {
+#ifdef _MSC_VER
+        __cpuidex(info, leaf, subleaf);
+#else
+        __cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+#endif
+    }
+
+    static bool detect_sse2()
+    {
+        int info[4];
+        cpuid(info, 1, 0);
+        return (info[3] & (1 << 26)) != 0;
+    }
+
+    static bool os_supports_avx()
+    {
+        // VEX encoded instructions also need the OS to save YMM state (OSXSAVE + XCR0 bits 1 and 2)
+        int info[4];
+        cpuid(info, 1, 0);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+    }
+
+    static bool detect_avx2()
+    {
+        int info[4];
+        cpuid(info, 0, 0);
+        if (info[0] < 7 || !os_supports_avx())
+            return false;
+
+        cpuid(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+
+    static bool detect_f16c()
+    {
+        int info[4];
+        cpuid(info, 1, 0);
+        return (info[2] & (1 << 29)) != 0 && os_supports_avx();
+    }
+
     void Core::Init()
     {
         glfwSetErrorCallback(error_callback);
@@ -24,4 +74,22 @@ namespace SimView
     {
         glfwTerminate();
     }
+
+    bool Core::HasSSE2()
+    {
+        static const bool result = detect_sse2();
+        return result;
+    }
+
+    bool Core::HasAVX2()
+    {
+        static const bool result = detect_avx2();
+        return result;
+    }
+
+    bool Core::HasF16C()
+    {
+        static const bool result = detect_f16c();
+        return result;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "SimView.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace SimView
+{
+	static long long Area(const Rect& rect)
+	{
+		return (long long)rect.width * rect.height;
+	}
+
+	static Rect Union(const Rect& a, const Rect& b)
+	{
+		int x0 = std::min(a.x, b.x);
+		int y0 = std::min(a.y, b.y);
+		int x1 = std::max(a.x + a.width, b.x + b.width);
+		int y1 = std::max(a.y + a.height, b.y + b.height);
+		return { x0, y0, x1 - x0, y1 - y0 };
+	}
+
+	static std::uint64_t HashTile(const Bitmap& image, int x0, int y0, int x1, int y1)
+	{
+		// Multiply-xor over 8 byte words, only needs to tell frames apart, not resist attacks
+		const std::uint64_t prime = 0x9E3779B97F4A7C15ull;
+		std::uint64_t hash = 0xCBF29CE484222325ull;
+		int pixelSize = image.GetPixelSize();
+		size_t rowBytes = size_t(x1 - x0) * pixelSize;
+		for (int y = y0; y < y1; y++)
+		{
+			const unsigned char* row = (const unsigned char*)image.data + (size_t(y) * image.width + x0) * pixelSize;
+			size_t i = 0;
+			for (; i + 8 <= rowBytes; i += 8)
+			{
+				std::uint64_t word;
+				std::memcpy(&word, row + i, sizeof(word));
+				hash = (hash ^ word) * prime;
+				hash ^= hash >> 29;
+			}
+			for (; i < rowBytes; i++)
+				hash = (hash ^ row[i]) * prime;
+		}
+		return hash;
+	}
+
+	void Bitmap::MarkDirty(int x, int y, int width, int height)
+	{
+		int x0 = std::max(x, 0);
+		int y0 = std::max(y, 0);
+		int x1 = std::min(x + width, this->width);
+		int y1 = std::min(y + height, this->height);
+		if (x0 >= x1 || y0 >= y1)
+			return;
+
+		// Merge with existing rectangles whenever that doesn't upload any extra pixels
+		Rect rect = { x0, y0, x1 - x0, y1 - y0 };
+		for (size_t i = 0; i < dirtyRects.size();)
+		{
+			Rect merged = Union(rect, dirtyRects[i]);
+			if (Area(merged) <= Area(rect) + Area(dirtyRects[i]))
+			{
+				rect = merged;
+				dirtyRects.erase(dirtyRects.begin() + i);
+				i = 0;
+				continue;
+			}
+			i++;
+		}
+		dirtyRects.push_back(rect);
+
+		if ((int)dirtyRects.size() > MaxDirtyRects)
+		{
+			Rect bounds = dirtyRects[0];
+			for (const Rect& other : dirtyRects)
+				bounds = Union(bounds, other);
+			dirtyRects = { bounds };
+		}
+	}
+
+	void Bitmap::MarkAllDirty()
+	{
+		dirtyRects.clear();
+		MarkDirty(0, 0, width, height);
+	}
+
+	void Bitmap::ClearDirty()
+	{
+		dirtyRects.clear();
+	}
+
+	void Bitmap::EnableTileHashing(int tileSize)
+	{
+		hashTileSize = tileSize;
+		int tilesX = (width + tileSize - 1) / tileSize;
+		int tilesY = (height + tileSize - 1) / tileSize;
+		tileHashes.assign(size_t(tilesX) * tilesY, 0);
+		MarkAllDirty();
+	}
+
+	void Bitmap::DisableTileHashing()
+	{
+		hashTileSize = 0;
+		tileHashes.clear();
+	}
+
+	void Bitmap::DetectChanges(ThreadPool* pool)
+	{
+		if (hashTileSize <= 0)
+			return;
+
+		int tilesX = (width + hashTileSize - 1) / hashTileSize;
+		int tilesY = (height + hashTileSize - 1) / hashTileSize;
+		std::vector<unsigned char> changed(size_t(tilesX) * tilesY, 0);
+
+		auto hashRow = [&](int ty)
+		{
+			for (int tx = 0; tx < tilesX; tx++)
+			{
+				int x0 = tx * hashTileSize;
+				int y0 = ty * hashTileSize;
+				std::uint64_t hash = HashTile(*this, x0, y0, std::min(x0 + hashTileSize, width), std::min(y0 + hashTileSize, height));
+				size_t index = size_t(ty) * tilesX + tx;
+				changed[index] = hash != tileHashes[index];
+				tileHashes[index] = hash;
+			}
+		};
+		if (pool != nullptr)
+			pool->ParallelFor(tilesY, hashRow);
+		else
+			for (int ty = 0; ty < tilesY; ty++)
+				hashRow(ty);
+
+		for (int ty = 0; ty < tilesY; ty++)
+			for (int tx = 0; tx < tilesX; tx++)
+				if (changed[size_t(ty) * tilesX + tx])
+					MarkDirty(tx * hashTileSize, ty * hashTileSize, hashTileSize, hashTileSize);
+	}
+
+	std::vector<Rect> Bitmap::TakeDirtyRects()
+	{
+		DetectChanges();
+		std::vector<Rect> rects = std::move(dirtyRects);
+		dirtyRects.clear();
+		return rects;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "SimView.hpp"
+
+namespace SimView
+{
+	// Move constructor
+	Fence::Fence(Fence&& other) noexcept
+	{
+		this->sync = other.sync;
+		other.sync = nullptr;
+	}
+
+	// Move assignment
+	Fence& Fence::operator=(Fence&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Clear();
+			this->sync = other.sync;
+			other.sync = nullptr;
+		}
+		return *this;
+	}
+
+	Fence::~Fence()
+	{
+		Clear();
+	}
+
+	void Fence::Set()
+	{
+		Clear();
+		sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	bool Fence::IsSignaled() const
+	{
+		if (sync == nullptr)
+			return true;
+		GLint status = GL_UNSIGNALED;
+		glGetSynciv(sync, GL_SYNC_STATUS, sizeof(status), nullptr, &status);
+		return status == GL_SIGNALED;
+	}
+
+	void Fence::Wait() const
+	{
+		if (sync == nullptr)
+			return;
+
+		// The first wait flushes so the fence is guaranteed to reach the GPU
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while (true)
+		{
+			GLenum result = glClientWaitSync(sync, flags, 1000000);
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+				return;
+			if (result == GL_WAIT_FAILED)
+				throw std::runtime_error("Fence Error: Failed to wait on fence\n");
+			flags = 0;
+		}
+	}
+
+	void Fence::Clear()
+	{
+		if (sync != nullptr)
+			glDeleteSync(sync);
+		sync = nullptr;
+	}
+}
\ No newline at end of file
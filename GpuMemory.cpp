@@ -0,0 +1,158 @@
+#include "SimView.hpp"
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace SimView
+{
+	static std::mutex registryMutex;
+	static GpuMemoryStats totalStats;
+	static GpuMemoryStats typeStats[GpuMemory::TypeCount];
+	static std::map<std::string, GpuMemoryStats> labelStats;
+
+	static void Apply(GpuMemoryStats& stats, std::int64_t bytes, int count)
+	{
+		stats.liveBytes = size_t(std::int64_t(stats.liveBytes) + bytes);
+		stats.liveCount += count;
+		stats.peakBytes = std::max(stats.peakBytes, stats.liveBytes);
+	}
+
+	void GpuMemory::Record(GpuResourceType type, const std::string& label, std::int64_t bytes, int count)
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		Apply(totalStats, bytes, count);
+		Apply(typeStats[(int)type], bytes, count);
+		Apply(labelStats[label], bytes, count);
+	}
+
+	GpuMemoryStats GpuMemory::GetTotal()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		return totalStats;
+	}
+
+	GpuMemoryStats GpuMemory::GetStats(GpuResourceType type)
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		return typeStats[(int)type];
+	}
+
+	GpuMemoryStats GpuMemory::GetStats(const std::string& label)
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		auto it = labelStats.find(label);
+		return it != labelStats.end() ? it->second : GpuMemoryStats();
+	}
+
+	std::map<std::string, GpuMemoryStats> GpuMemory::GetLabelStats()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		return labelStats;
+	}
+
+	const char* GpuMemory::GetTypeName(GpuResourceType type)
+	{
+		static const char* names[TypeCount] = { "Texture", "TextureArray", "VertexBuffer", "IndexBuffer", "PixelBuffer" };
+		return names[(int)type];
+	}
+
+	size_t GpuMemory::GetTextureBytes(GLenum internalFormat, int width, int height, int levels, int layers)
+	{
+		// Block compressed formats are sized in 4x4 blocks, everything else by the matching pixel format
+		int blockBytes = 0;
+		if (internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT)
+			blockBytes = 8;
+		else if (internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || internalFormat == GL_COMPRESSED_RGBA_BPTC_UNORM)
+			blockBytes = 16;
+
+		int texelBytes = 4;
+		for (int i = 0; i <= (int)PixelFormat::RGBA32F; i++)
+		{
+			const PixelFormatInfo& info = PixelFormatInfo::Get((PixelFormat)i);
+			if (info.internalFormat == internalFormat)
+				texelBytes = info.bytes;
+		}
+
+		size_t total = 0;
+		for (int level = 0; level < levels; level++)
+		{
+			int levelWidth = std::max(width >> level, 1);
+			int levelHeight = std::max(height >> level, 1);
+			if (blockBytes > 0)
+				total += size_t((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockBytes;
+			else
+				total += size_t(levelWidth) * levelHeight * texelBytes;
+		}
+		return total * layers;
+	}
+
+	GpuAllocation::GpuAllocation(GpuResourceType type, size_t bytes, std::string label)
+	{
+		this->type = type;
+		this->bytes = bytes;
+		this->label = label;
+		this->active = true;
+		GpuMemory::Record(type, label, bytes, 1);
+	}
+
+	// Move constructor
+	GpuAllocation::GpuAllocation(GpuAllocation&& other) noexcept
+	{
+		this->type = other.type;
+		this->label = std::move(other.label);
+		this->bytes = other.bytes;
+		this->active = other.active;
+		other.bytes = 0;
+		other.active = false;
+	}
+
+	// Move assignment
+	GpuAllocation& GpuAllocation::operator=(GpuAllocation&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			this->type = other.type;
+			this->label = std::move(other.label);
+			this->bytes = other.bytes;
+			this->active = other.active;
+			other.bytes = 0;
+			other.active = false;
+		}
+		return *this;
+	}
+
+	GpuAllocation::~GpuAllocation()
+	{
+		Release();
+	}
+
+	void GpuAllocation::Resize(size_t bytes)
+	{
+		if (active)
+			GpuMemory::Record(type, label, std::int64_t(bytes) - std::int64_t(this->bytes), 0);
+		this->bytes = bytes;
+	}
+
+	void GpuAllocation::SetLabel(std::string label)
+	{
+		if (active)
+		{
+			GpuMemory::Record(type, this->label, -std::int64_t(bytes), -1);
+			GpuMemory::Record(type, label, bytes, 1);
+		}
+		this->label = label;
+	}
+
+	void GpuAllocation::Release()
+	{
+		if (active)
+			GpuMemory::Record(type, label, -std::int64_t(bytes), -1);
+		bytes = 0;
+		active = false;
+	}
+}
\ No newline at end of file
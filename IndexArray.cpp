@@ -1,73 +1,323 @@
 #include "SimView.hpp"
+#include <immintrin.h>
 
 namespace SimView
 {
-	IndexArray::IndexArray()
+	// Largest index, compared unsigned so negative input forces 32-bit indices
+
+	static u32 MaxIndex_Scalar(const int* src, size_t count)
 	{
-		this->hasArray = false;
+		u32 maxIndex = 0;
+		for (size_t i = 0; i < count; i++)
+			maxIndex = std::max(maxIndex, (u32)src[i]);
+		return maxIndex;
 	}
 
-	IndexArray::IndexArray(int elemCount, int* data)
+	// SSE2 has no unsigned 32-bit max, so compare with the sign bit flipped
+	static u32 MaxIndex_SSE2(const int* src, size_t count)
 	{
-		GLuint id;
-		glGenBuffers(1, &id);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, elemCount * sizeof(int), data, GL_DYNAMIC_DRAW);
-		this->id = id;
-		this->count = elemCount;
-		this->hasArray = true;
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		__m128i bias = _mm_set1_epi32((int)0x80000000);
+		__m128i maxBiased = bias;
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + i)), bias);
+			__m128i greater = _mm_cmpgt_epi32(v, maxBiased);
+			maxBiased = _mm_or_si128(_mm_and_si128(greater, v), _mm_andnot_si128(greater, maxBiased));
+		}
+		alignas(16) u32 lanes[4];
+		_mm_store_si128((__m128i*)lanes, _mm_xor_si128(maxBiased, bias));
+		u32 maxIndex = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		return std::max(maxIndex, MaxIndex_Scalar(src + i, count - i));
+	}
+
+	static u32 MaxIndex_AVX2(const int* src, size_t count)
+	{
+		__m256i maxIndices = _mm256_setzero_si256();
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+			maxIndices = _mm256_max_epu32(maxIndices, _mm256_loadu_si256((const __m256i*)(src + i)));
+		alignas(32) u32 lanes[8];
+		_mm256_store_si256((__m256i*)lanes, maxIndices);
+		u32 maxIndex = 0;
+		for (u32 lane : lanes)
+			maxIndex = std::max(maxIndex, lane);
+		return std::max(maxIndex, MaxIndex_Scalar(src + i, count - i));
+	}
+
+	// 32-bit to 16-bit narrowing, input must already fit
+
+	static void Narrow16_Scalar(const int* src, u16* dst, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			dst[i] = (u16)src[i];
 	}
 
-	IndexArray::IndexArray(IndexArray& other)
+	// packs_epi32 is signed, so shift into its range and flip the top bit back
+	static void Narrow16_SSE2(const int* src, u16* dst, size_t count)
 	{
-		if (this->hasArray)
+		__m128i bias32 = _mm_set1_epi32(0x8000);
+		__m128i bias16 = _mm_set1_epi16((short)0x8000);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
 		{
-			glDeleteBuffers(1, &id);
+			__m128i a = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(src + i)), bias32);
+			__m128i b = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(src + i + 4)), bias32);
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(_mm_packs_epi32(a, b), bias16));
+		}
+		Narrow16_Scalar(src + i, dst + i, count - i);
+	}
+
+	// Packs work per 128-bit lane, so the halves are reordered after packing
+	static void Narrow16_AVX2(const int* src, u16* dst, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m256i a = _mm256_loadu_si256((const __m256i*)(src + i));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(src + i + 8));
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256((__m256i*)(dst + i), packed);
+		}
+		Narrow16_Scalar(src + i, dst + i, count - i);
+	}
+
+	// 32-bit to 8-bit narrowing, input must already fit
+
+	static void Narrow8_Scalar(const int* src, u8* dst, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			dst[i] = (u8)src[i];
+	}
+
+	static void Narrow8_SSE2(const int* src, u8* dst, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i ab = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(src + i)), _mm_loadu_si128((const __m128i*)(src + i + 4)));
+			__m128i cd = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)), _mm_loadu_si128((const __m128i*)(src + i + 12)));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(ab, cd));
+		}
+		Narrow8_Scalar(src + i, dst + i, count - i);
+	}
+
+	static void Narrow8_AVX2(const int* src, u8* dst, size_t count)
+	{
+		__m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		size_t i = 0;
+		for (; i + 32 <= count; i += 32)
+		{
+			__m256i ab = _mm256_packs_epi32(_mm256_loadu_si256((const __m256i*)(src + i)), _mm256_loadu_si256((const __m256i*)(src + i + 8)));
+			__m256i cd = _mm256_packs_epi32(_mm256_loadu_si256((const __m256i*)(src + i + 16)), _mm256_loadu_si256((const __m256i*)(src + i + 24)));
+			__m256i packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(ab, cd), order);
+			_mm256_storeu_si256((__m256i*)(dst + i), packed);
 		}
+		Narrow8_Scalar(src + i, dst + i, count - i);
+	}
+
+	// A maxIndex hint only widens, so it can reserve room for later Set calls but never truncate the data
+	static GLenum ChooseType(const int* data, int elemCount, int maxIndex)
+	{
+		if (data == nullptr && maxIndex < 0)
+			throw std::runtime_error("IndexArray Error: An array created without data needs a maxIndex\n");
+
+		u32 largest = maxIndex >= 0 ? (u32)maxIndex : 0;
+		if (data != nullptr)
+			largest = std::max(largest, IndexArray::FindMaxIndex(data, elemCount));
+		return IndexArray::GetIndexType(largest);
+	}
+
+	// The index type is fixed at creation, from the data and maxIndex, whichever is larger
+	IndexArray::IndexArray(int elemCount, int* data, int maxIndex)
+	{
+		Create(nullptr, elemCount, data, ChooseType(data, elemCount, maxIndex));
+	}
+
+	IndexArray::IndexArray(BufferHeap& heap, int elemCount, int* data, int maxIndex)
+	{
+		Create(&heap, elemCount, data, ChooseType(data, elemCount, maxIndex));
+	}
+
+	// Move constructor
+	IndexArray::IndexArray(IndexArray&& other) noexcept
+	{
 		this->id = other.id;
 		this->count = other.count;
-		this->hasArray = other.hasArray;
-		other.hasArray = false;
+		this->type = other.type;
+		this->heap = std::move(other.heap);
+		this->slice = other.slice;
+		this->allocation = std::move(other.allocation);
+		other.id = 0;
+		other.heap = HeapRef();
+		other.slice = -1;
 	}
 
-	IndexArray& IndexArray::operator=(IndexArray&& other)
+	// Move assignment
+	IndexArray& IndexArray::operator=(IndexArray&& other) noexcept
 	{
 		if (this != &other)
 		{
-			if (this->hasArray)
-			{
-				glDeleteBuffers(1, &id);
-			}
+			Destroy();
 			this->id = other.id;
 			this->count = other.count;
-			this->hasArray = other.hasArray;
-			other.hasArray = false;
+			this->type = other.type;
+			this->heap = std::move(other.heap);
+			this->slice = other.slice;
+			this->allocation = std::move(other.allocation);
+			other.id = 0;
+			other.heap = HeapRef();
+			other.slice = -1;
 		}
 		return *this;
 	}
 
 	IndexArray::~IndexArray()
 	{
-		if (hasArray)
+		Destroy();
+	}
+
+	GLuint IndexArray::GetBuffer() const
+	{
+		return heap ? heap->GetSlice(slice).buffer : id;
+	}
+
+	size_t IndexArray::GetOffset() const
+	{
+		return heap ? heap->GetSlice(slice).offset : 0;
+	}
+
+	int IndexArray::GetIndexSize() const
+	{
+		return GetIndexSize(type);
+	}
+
+	size_t IndexArray::GetByteSize() const
+	{
+		return size_t(count) * GetIndexSize();
+	}
+
+	// The buffer and type never change after creation, so bound arrays and meshes stay valid
+	void IndexArray::Set(int index, int elemCount, int* data)
+	{
+		if (GetIndexSize(GetIndexType(FindMaxIndex(data, elemCount))) > GetIndexSize())
+			throw std::runtime_error("IndexArray Error: Indices do not fit the array's index type, create it with a larger maxIndex\n");
+
+		size_t offset = GetOffset() + size_t(index) * GetIndexSize();
+		if (type == GL_UNSIGNED_INT)
 		{
-			glDeleteBuffers(1, &id);
+			glNamedBufferSubData(GetBuffer(), offset, elemCount * sizeof(int), data);
+			return;
 		}
+		std::vector<unsigned char> narrowed(size_t(elemCount) * GetIndexSize());
+		Narrow(data, narrowed.data(), elemCount, type);
+		glNamedBufferSubData(GetBuffer(), offset, narrowed.size(), narrowed.data());
 	}
 
-	void IndexArray::Set(int index, int elemCount, int* data)
+	void IndexArray::SetLabel(std::string label)
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
-		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, index * sizeof(int), elemCount * sizeof(int), data);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		if (id != 0)
+			glObjectLabel(GL_BUFFER, id, -1, label.c_str());
+		allocation.SetLabel(label);
 	}
 
 	void IndexArray::Destroy()
 	{
-		if (hasArray)
+		if (id != 0)
 		{
 			glDeleteBuffers(1, &id);
 		}
-		hasArray = false;
+		heap.Free(slice);
+		id = 0;
+		heap = HeapRef();
+		slice = -1;
+		allocation.Release();
+	}
+
+	GLenum IndexArray::GetIndexType(u32 maxIndex)
+	{
+		if (maxIndex <= 0xFF)
+			return GL_UNSIGNED_BYTE;
+		if (maxIndex <= 0xFFFF)
+			return GL_UNSIGNED_SHORT;
+		return GL_UNSIGNED_INT;
+	}
+
+	int IndexArray::GetIndexSize(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_UNSIGNED_BYTE:
+			return 1;
+		case GL_UNSIGNED_SHORT:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	u32 IndexArray::FindMaxIndex(const int* data, size_t count)
+	{
+		if (Core::HasAVX2())
+			return MaxIndex_AVX2(data, count);
+		else if (Core::HasSSE2())
+			return MaxIndex_SSE2(data, count);
+		else
+			return MaxIndex_Scalar(data, count);
+	}
+
+	void IndexArray::Narrow(const int* src, void* dst, size_t count, GLenum type)
+	{
+		if (type == GL_UNSIGNED_BYTE)
+		{
+			if (Core::HasAVX2())
+				Narrow8_AVX2(src, (u8*)dst, count);
+			else if (Core::HasSSE2())
+				Narrow8_SSE2(src, (u8*)dst, count);
+			else
+				Narrow8_Scalar(src, (u8*)dst, count);
+		}
+		else if (type == GL_UNSIGNED_SHORT)
+		{
+			if (Core::HasAVX2())
+				Narrow16_AVX2(src, (u16*)dst, count);
+			else if (Core::HasSSE2())
+				Narrow16_SSE2(src, (u16*)dst, count);
+			else
+				Narrow16_Scalar(src, (u16*)dst, count);
+		}
+		else
+		{
+			std::memcpy(dst, src, count * sizeof(int));
+		}
+	}
+
+	void IndexArray::Create(BufferHeap* heap, int elemCount, const int* data, GLenum type)
+	{
+		this->count = elemCount;
+		this->type = type;
+
+		std::vector<unsigned char> narrowed;
+		const void* upload = data;
+		if (data != nullptr && type != GL_UNSIGNED_INT)
+		{
+			narrowed.resize(GetByteSize());
+			Narrow(data, narrowed.data(), elemCount, type);
+			upload = narrowed.data();
+		}
+
+		if (heap != nullptr)
+		{
+			this->heap = heap->GetRef();
+			this->slice = heap->Allocate(GetByteSize(), GetIndexSize());
+			if (upload != nullptr)
+				heap->Write(slice, 0, GetByteSize(), upload);
+		}
+		else
+		{
+			glCreateBuffers(1, &id);
+			glNamedBufferStorage(id, GetByteSize(), upload, GL_DYNAMIC_STORAGE_BIT);
+			this->allocation = GpuAllocation(GpuResourceType::IndexBuffer, GetByteSize());
+		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "SimView.hpp"
+
+namespace SimView
+{
+	MappedBitmap::MappedBitmap(int width, int height, PixelFormat format)
+	{
+		size_t bytes = size_t(width) * height * PixelFormatInfo::Get(format).bytes;
+		regionBytes = (bytes + BitmapPool::Alignment - 1) & ~(BitmapPool::Alignment - 1);
+
+		// Read access lets a simulation sample the presented region while writing the other one
+		GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, regionBytes * BufferCount, nullptr, flags);
+		mapped = (unsigned char*)glMapNamedBufferRange(buffer, 0, regionBytes * BufferCount, flags);
+		if (mapped == nullptr)
+		{
+			// The destructor does not run for a throwing constructor
+			glDeleteBuffers(1, &buffer);
+			buffer = 0;
+			throw std::runtime_error("MappedBitmap Error: Failed to map pixel buffer\n");
+		}
+		allocation = GpuAllocation(GpuResourceType::PixelBuffer, regionBytes * BufferCount);
+
+		for (int i = 0; i < BufferCount; i++)
+			regions[i] = Bitmap::Wrap(mapped + i * regionBytes, width, height, format);
+	}
+
+	MappedBitmap::~MappedBitmap()
+	{
+		for (int i = 0; i < BufferCount; i++)
+			fences[i].Clear();
+		glUnmapNamedBuffer(buffer);
+		glDeleteBuffers(1, &buffer);
+	}
+
+	Bitmap& MappedBitmap::GetBitmap()
+	{
+		return regions[current];
+	}
+
+	const Bitmap& MappedBitmap::GetPresented() const
+	{
+		return regions[(current + BufferCount - 1) % BufferCount];
+	}
+
+	void MappedBitmap::Swap()
+	{
+		fences[current].Set();
+		current = (current + 1) % BufferCount;
+
+		// The GPU copy out of this region was issued BufferCount presents ago and has usually finished
+		fences[current].Wait();
+		regions[current].ClearDirty();
+	}
+
+	void MappedBitmap::Present(Texture& texture)
+	{
+		Bitmap& image = regions[current];
+		const PixelFormatInfo& info = PixelFormatInfo::Get(image.format);
+		size_t offset = current * regionBytes;
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(image.width));
+		glTextureSubImage2D(texture.id, 0, 0, 0, image.width, image.height, info.format, info.type, (const void*)offset);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		Swap();
+	}
+
+	void MappedBitmap::PresentLayer(TextureArray& texArray, int layer)
+	{
+		Bitmap& image = regions[current];
+		const PixelFormatInfo& info = PixelFormatInfo::Get(image.format);
+		size_t offset = current * regionBytes;
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(image.width));
+		glTextureSubImage3D(texArray.id, 0, 0, 0, layer, image.width, image.height, 1, info.format, info.type, (const void*)offset);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		Swap();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "SimView.hpp"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SimView
+{
+	MappedFile::MappedFile(std::string path)
+	{
+		// The OS handles are closed as soon as the view exists, the mapping alone keeps the file contents alive
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("MappedFile Error: Failed to open " + path + "\n");
+
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		size = (size_t)fileSize.QuadPart;
+		if (size == 0)
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping == nullptr)
+			throw std::runtime_error("MappedFile Error: Failed to map " + path + "\n");
+
+		data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("MappedFile Error: Failed to open " + path + "\n");
+
+		struct stat info;
+		fstat(fd, &info);
+		size = (size_t)info.st_size;
+		if (size == 0)
+		{
+			close(fd);
+			return;
+		}
+
+		void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (ptr != MAP_FAILED)
+		{
+			madvise(ptr, size, MADV_SEQUENTIAL);
+			data = (const unsigned char*)ptr;
+		}
+#endif
+		if (data == nullptr)
+			throw std::runtime_error("MappedFile Error: Failed to map " + path + "\n");
+	}
+
+	// Move constructor
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		this->data = other.data;
+		this->size = other.size;
+
+		other.data = nullptr;
+		other.size = 0;
+	}
+
+	// Move assignment
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+
+			this->data = other.data;
+			this->size = other.size;
+
+			other.data = nullptr;
+			other.size = 0;
+		}
+		return *this;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	void MappedFile::Close()
+	{
+		if (data != nullptr)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+#else
+			munmap((void*)data, size);
+#endif
+		}
+		data = nullptr;
+		size = 0;
+	}
+}
\ No newline at end of file
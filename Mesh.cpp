@@ -0,0 +1,292 @@
+#include "SimView.hpp"
+
+namespace SimView
+{
+	static GLuint defaultVertexArray = 0;
+	static GLuint boundVertexArray = 0;
+	// Which mesh's buffers are currently attached to each VAO
+	static std::map<GLuint, const Mesh*> attachedMeshes;
+
+	Mesh::Mesh()
+	{
+		glCreateVertexArrays(1, &id);
+		formatId = id;
+	}
+
+	Mesh::Mesh(GLuint formatId, size_t bindingCount)
+	{
+		this->formatId = formatId;
+		buffers.assign(bindingCount, 0);
+		offsets.assign(bindingCount, 0);
+		sources.assign(bindingCount, Source());
+	}
+
+	// Move constructor
+	Mesh::Mesh(Mesh&& other) noexcept
+	{
+		other.Forget();
+		this->id = other.id;
+		this->formatId = other.formatId;
+		this->buffers = std::move(other.buffers);
+		this->offsets = std::move(other.offsets);
+		this->strides = std::move(other.strides);
+		this->sources = std::move(other.sources);
+		this->indexBuffer = other.indexBuffer;
+		this->indexOffset = other.indexOffset;
+		this->indexHeap = other.indexHeap;
+		this->indexSlice = other.indexSlice;
+		this->indexType = other.indexType;
+		this->indexCount = other.indexCount;
+		this->vertexCount = other.vertexCount;
+		other.id = 0;
+		other.formatId = 0;
+	}
+
+	// Move assignment
+	Mesh& Mesh::operator=(Mesh&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Destroy();
+			other.Forget();
+			this->id = other.id;
+			this->formatId = other.formatId;
+			this->buffers = std::move(other.buffers);
+			this->offsets = std::move(other.offsets);
+			this->strides = std::move(other.strides);
+			this->sources = std::move(other.sources);
+			this->indexBuffer = other.indexBuffer;
+			this->indexOffset = other.indexOffset;
+			this->indexHeap = other.indexHeap;
+			this->indexSlice = other.indexSlice;
+			this->indexType = other.indexType;
+			this->indexCount = other.indexCount;
+			this->vertexCount = other.vertexCount;
+			other.id = 0;
+			other.formatId = 0;
+		}
+		return *this;
+	}
+
+	Mesh::~Mesh()
+	{
+		Destroy();
+	}
+
+	// The format owner must outlive the meshes sharing it, and gain no bindings after they are made
+	Mesh Mesh::ShareFormat(const Mesh& format)
+	{
+		if (format.id == 0)
+			throw std::runtime_error("Mesh Error: Format source does not own a vertex array\n");
+		Mesh mesh(format.formatId, format.buffers.size());
+		mesh.strides = format.strides;
+		return mesh;
+	}
+
+	int Mesh::AddBinding(const VertexLayout& layout, const std::vector<GLint>& locs, GLuint divisor)
+	{
+		if (id == 0)
+			throw std::runtime_error("Mesh Error: Cannot change a shared vertex format\n");
+
+		GLuint binding = GLuint(buffers.size());
+		SetFormat(id, binding, layout, locs);
+		glVertexArrayBindingDivisor(id, binding, divisor);
+		buffers.push_back(0);
+		offsets.push_back(0);
+		strides.push_back(GLsizei(layout.stride));
+		sources.push_back(Source());
+		return int(binding);
+	}
+
+	int Mesh::AddArray(VArray<float>& array, GLint loc, GLuint divisor)
+	{
+		return AddArray(array, { loc }, VertexLayout().Add(VertexFormat::Float, array.elemSize), divisor);
+	}
+
+	int Mesh::AddArray(VArray<int>& array, GLint loc, GLuint divisor)
+	{
+		return AddArray(array, { loc }, VertexLayout().Add(VertexFormat::Int, array.elemSize), divisor);
+	}
+
+	void Mesh::SetStorage(int binding, const std::shared_ptr<SharedBuffer>& storage)
+	{
+		if (binding < 0 || binding >= int(buffers.size()))
+			throw std::runtime_error("Mesh Error: Binding index out of range\n");
+		sources[binding].storage = storage;
+		sources[binding].splits = storage ? storage->splits : 0;
+		sources[binding].tracked = storage != nullptr;
+		buffers[binding] = storage ? storage->GetBuffer() : 0;
+		offsets[binding] = storage ? GLintptr(storage->GetOffset()) : 0;
+		Forget();
+	}
+
+	// A raw buffer is used as given and never re-resolved
+	void Mesh::SetBuffer(int binding, GLuint buffer, size_t offset)
+	{
+		if (binding < 0 || binding >= int(buffers.size()))
+			throw std::runtime_error("Mesh Error: Binding index out of range\n");
+		sources[binding] = Source();
+		buffers[binding] = buffer;
+		offsets[binding] = GLintptr(offset);
+		Forget();
+	}
+
+	// The index array must outlive the mesh's draws; heap slices are re-resolved on Bind
+	void Mesh::SetIndexArray(IndexArray& array)
+	{
+		indexHeap = array.heap;
+		indexSlice = array.slice;
+		indexBuffer = array.GetBuffer();
+		indexOffset = array.GetOffset();
+		indexType = array.type;
+		indexCount = array.count;
+		Forget();
+	}
+
+	// Buffers are only re-attached when another mesh sharing the VAO was bound since, or they moved
+	void Mesh::Bind() const
+	{
+		bool moved = Resolve();
+		if (boundVertexArray != formatId)
+		{
+			glBindVertexArray(formatId);
+			boundVertexArray = formatId;
+		}
+
+		const Mesh*& attached = attachedMeshes[formatId];
+		if (attached != this || moved)
+		{
+			if (!buffers.empty())
+				glVertexArrayVertexBuffers(formatId, 0, GLsizei(buffers.size()), buffers.data(), offsets.data(), strides.data());
+			glVertexArrayElementBuffer(formatId, indexBuffer);
+			attached = this;
+		}
+	}
+
+	void Mesh::SetLabel(std::string label)
+	{
+		if (id != 0)
+			glObjectLabel(GL_VERTEX_ARRAY, id, -1, label.c_str());
+	}
+
+	void Mesh::Destroy()
+	{
+		Forget();
+		if (id != 0)
+		{
+			attachedMeshes.erase(id);
+			if (boundVertexArray == id)
+				boundVertexArray = 0;
+			glDeleteVertexArrays(1, &id);
+		}
+		id = 0;
+		formatId = 0;
+	}
+
+	void Mesh::SetFormat(GLuint vao, GLuint binding, const VertexLayout& layout, const std::vector<GLint>& locs)
+	{
+		if (locs.size() != layout.attributes.size())
+			throw std::runtime_error("Mesh Error: Layout attribute count does not match location count\n");
+
+		for (size_t i = 0; i < locs.size(); i++)
+		{
+			// Attributes the shader compiled out have location -1
+			GLint loc = locs[i];
+			if (loc < 0)
+				continue;
+
+			const VertexAttribute& attribute = layout.attributes[i];
+			GLuint relative = GLuint(attribute.offset);
+			glEnableVertexArrayAttrib(vao, loc);
+			switch (attribute.format)
+			{
+			case VertexFormat::Float:
+				glVertexArrayAttribFormat(vao, loc, attribute.components, GL_FLOAT, GL_FALSE, relative);
+				break;
+			case VertexFormat::Half:
+				glVertexArrayAttribFormat(vao, loc, attribute.components, GL_HALF_FLOAT, GL_FALSE, relative);
+				break;
+			case VertexFormat::UByteNorm:
+				glVertexArrayAttribFormat(vao, loc, attribute.components, GL_UNSIGNED_BYTE, GL_TRUE, relative);
+				break;
+			case VertexFormat::UShortNorm:
+				glVertexArrayAttribFormat(vao, loc, attribute.components, GL_UNSIGNED_SHORT, GL_TRUE, relative);
+				break;
+			case VertexFormat::Int:
+				glVertexArrayAttribIFormat(vao, loc, attribute.components, GL_INT, relative);
+				break;
+			case VertexFormat::Packed1010102:
+				glVertexArrayAttribFormat(vao, loc, 4, GL_INT_2_10_10_10_REV, GL_TRUE, relative);
+				break;
+			}
+			glVertexArrayAttribBinding(vao, loc, binding);
+		}
+	}
+
+	void Mesh::SetDefault(GLuint vao)
+	{
+		defaultVertexArray = vao;
+		glBindVertexArray(vao);
+		boundVertexArray = vao;
+	}
+
+	GLuint Mesh::GetDefault()
+	{
+		return defaultVertexArray;
+	}
+
+	// The per-call BindArray functions edit whichever VAO is bound, so they switch back to the default one first
+	void Mesh::BindDefault()
+	{
+		if (boundVertexArray != defaultVertexArray)
+		{
+			glBindVertexArray(defaultVertexArray);
+			boundVertexArray = defaultVertexArray;
+		}
+	}
+
+	// Looks up where tracked arrays and the index slice live now, returns true if any moved
+	bool Mesh::Resolve() const
+	{
+		bool moved = false;
+		for (size_t i = 0; i < sources.size(); i++)
+		{
+			if (!sources[i].tracked)
+				continue;
+
+			std::shared_ptr<SharedBuffer> storage = sources[i].storage.lock();
+			if (!storage)
+				throw std::runtime_error("Mesh Error: An array used by the mesh was destroyed or moved to a new buffer, call SetArray again\n");
+			if (storage->splits != sources[i].splits)
+				throw std::runtime_error("Mesh Error: An array used by the mesh was split from its copies by VArray::Set, call SetArray again\n");
+
+			GLuint buffer = storage->GetBuffer();
+			GLintptr offset = GLintptr(storage->GetOffset());
+			if (buffer != buffers[i] || offset != offsets[i])
+			{
+				buffers[i] = buffer;
+				offsets[i] = offset;
+				moved = true;
+			}
+		}
+
+		if (indexHeap)
+		{
+			const BufferSlice& slice = indexHeap->GetSlice(indexSlice);
+			if (slice.buffer != indexBuffer || slice.offset != indexOffset)
+			{
+				indexBuffer = slice.buffer;
+				indexOffset = slice.offset;
+				moved = true;
+			}
+		}
+		return moved;
+	}
+
+	void Mesh::Forget() const
+	{
+		auto it = attachedMeshes.find(formatId);
+		if (it != attachedMeshes.end() && it->second == this)
+			attachedMeshes.erase(it);
+	}
+}
\ No newline at end of file
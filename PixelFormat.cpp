@@ -0,0 +1,128 @@
+#include "SimView.hpp"
+#include <cstring>
+#include <immintrin.h>
+
+namespace SimView
+{
+	static const PixelFormatInfo formatInfos[] = {
+		{ 1, 1, false, GL_R8, GL_RED, GL_UNSIGNED_BYTE },
+		{ 2, 2, false, GL_RG8, GL_RG, GL_UNSIGNED_BYTE },
+		{ 4, 4, false, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE },
+		{ 2, 1, true, GL_R16F, GL_RED, GL_HALF_FLOAT },
+		{ 4, 2, true, GL_RG16F, GL_RG, GL_HALF_FLOAT },
+		{ 8, 4, true, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT },
+		{ 4, 1, true, GL_R32F, GL_RED, GL_FLOAT },
+		{ 8, 2, true, GL_RG32F, GL_RG, GL_FLOAT },
+		{ 16, 4, true, GL_RGBA32F, GL_RGBA, GL_FLOAT },
+	};
+
+	const PixelFormatInfo& PixelFormatInfo::Get(PixelFormat format)
+	{
+		return formatInfos[(int)format];
+	}
+
+	int PixelFormatInfo::UnpackAlignment(int width) const
+	{
+		int rowBytes = width * bytes;
+		if (rowBytes % 8 == 0)
+			return 8;
+		if (rowBytes % 4 == 0)
+			return 4;
+		if (rowBytes % 2 == 0)
+			return 2;
+		return 1;
+	}
+
+	Half Half::FromFloat(float value)
+	{
+		std::uint32_t f;
+		std::memcpy(&f, &value, sizeof(f));
+		std::uint32_t sign = (f >> 16) & 0x8000;
+		std::uint32_t exponent = (f >> 23) & 0xFF;
+		std::uint32_t mantissa = f & 0x7FFFFF;
+
+		if (exponent == 0xFF)
+			return { (std::uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0)) };
+
+		int e = (int)exponent - 127 + 15;
+		if (e >= 31)
+			return { (std::uint16_t)(sign | 0x7C00) };
+		if (e <= 0)
+		{
+			// Subnormal or zero, round to nearest even
+			if (e < -10)
+				return { (std::uint16_t)sign };
+			mantissa |= 0x800000;
+			int shift = 14 - e;
+			std::uint32_t half = mantissa >> shift;
+			std::uint32_t rest = mantissa & ((1u << shift) - 1);
+			std::uint32_t midpoint = 1u << (shift - 1);
+			if (rest > midpoint || (rest == midpoint && (half & 1)))
+				half++;
+			return { (std::uint16_t)(sign | half) };
+		}
+
+		std::uint32_t half = sign | (e << 10) | (mantissa >> 13);
+		std::uint32_t rest = mantissa & 0x1FFF;
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+			half++;
+		return { (std::uint16_t)half };
+	}
+
+	float Half::ToFloat() const
+	{
+		std::uint32_t sign = (std::uint32_t)(bits & 0x8000) << 16;
+		std::uint32_t exponent = (bits >> 10) & 0x1F;
+		std::uint32_t mantissa = bits & 0x3FF;
+		std::uint32_t f;
+
+		if (exponent == 0x1F)
+			f = sign | 0x7F800000 | (mantissa << 13);
+		else if (exponent != 0)
+			f = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		else if (mantissa == 0)
+			f = sign;
+		else
+		{
+			// Normalize the subnormal
+			int e = -1;
+			do
+			{
+				mantissa <<= 1;
+				e++;
+			} while ((mantissa & 0x400) == 0);
+			f = sign | ((127 - 15 - e) << 23) | ((mantissa & 0x3FF) << 13);
+		}
+
+		float value;
+		std::memcpy(&value, &f, sizeof(value));
+		return value;
+	}
+
+	void Half::FromFloats(const float* src, Half* dst, size_t count)
+	{
+		size_t i = 0;
+		if (Core::HasF16C())
+		{
+			for (; i + 8 <= count; i += 8)
+			{
+				__m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+				_mm_storeu_si128((__m128i*)(dst + i), halves);
+			}
+		}
+		for (; i < count; i++)
+			dst[i] = FromFloat(src[i]);
+	}
+
+	void Half::ToFloats(const Half* src, float* dst, size_t count)
+	{
+		size_t i = 0;
+		if (Core::HasF16C())
+		{
+			for (; i + 8 <= count; i += 8)
+				_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+		}
+		for (; i < count; i++)
+			dst[i] = src[i].ToFloat();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,243 @@
+#include "SimView.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+namespace SimView
+{
+	static const int bandRows = 16;
+
+	struct FilterTaps
+	{
+		std::vector<int> first;
+		std::vector<int> count;
+		std::vector<float> weights;
+		int maxTaps = 0;
+	};
+
+	static float FilterRadius(ResampleFilter filter)
+	{
+		switch (filter)
+		{
+		case(ResampleFilter::Box):
+			return 0.5f;
+		case(ResampleFilter::Bilinear):
+			return 1.f;
+		default:
+			return 3.f;
+		}
+	}
+
+	static float FilterWeight(ResampleFilter filter, float x)
+	{
+		switch (filter)
+		{
+		case(ResampleFilter::Box):
+			return (x >= -0.5f && x < 0.5f) ? 1.f : 0.f;
+		case(ResampleFilter::Bilinear):
+			return std::max(0.f, 1.f - std::abs(x));
+		default:
+		{
+			if (x == 0.f)
+				return 1.f;
+			if (std::abs(x) >= 3.f)
+				return 0.f;
+			const float pi = 3.14159265358979f;
+			float px = pi * x;
+			return 3.f * std::sin(px) * std::sin(px / 3.f) / (px * px);
+		}
+		}
+	}
+
+	// Weights for every destination sample along one axis, taps are clamped to the source edge
+	static FilterTaps BuildTaps(int srcSize, int dstSize, ResampleFilter filter)
+	{
+		FilterTaps taps;
+		float scale = srcSize / (float)dstSize;
+		float filterScale = std::max(scale, 1.f);
+		float support = FilterRadius(filter) * filterScale;
+		taps.maxTaps = (int)std::ceil(support * 2) + 1;
+		taps.first.resize(dstSize);
+		taps.count.resize(dstSize);
+		taps.weights.resize(size_t(dstSize) * taps.maxTaps);
+
+		for (int i = 0; i < dstSize; i++)
+		{
+			float center = (i + 0.5f) * scale;
+			int left = (int)std::floor(center - support);
+			int count = std::min((int)std::ceil(center + support) - left, taps.maxTaps);
+			float* weights = &taps.weights[size_t(i) * taps.maxTaps];
+
+			float total = 0;
+			for (int j = 0; j < count; j++)
+			{
+				weights[j] = FilterWeight(filter, (left + j + 0.5f - center) / filterScale);
+				total += weights[j];
+			}
+			if (total == 0)
+			{
+				// Nearest sample when the kernel misses every texel
+				count = 1;
+				left = std::clamp((int)center, 0, srcSize - 1);
+				weights[0] = total = 1;
+			}
+			for (int j = 0; j < count; j++)
+				weights[j] /= total;
+
+			taps.first[i] = left;
+			taps.count[i] = count;
+		}
+		return taps;
+	}
+
+	static inline __m128 LoadColor(Color color)
+	{
+		int bits;
+		std::memcpy(&bits, &color, sizeof(bits));
+		__m128i zero = _mm_setzero_si128();
+		__m128i px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero);
+		return _mm_cvtepi32_ps(px);
+	}
+
+	static void ResampleRows(const Bitmap& src, Bitmap& dst, const FilterTaps& xTaps, const FilterTaps& yTaps, int y0, int y1)
+	{
+		std::vector<float> acc(size_t(dst.width) * 4);
+		std::vector<float> row(size_t(dst.width) * 4);
+
+		for (int y = y0; y < y1; y++)
+		{
+			std::fill(acc.begin(), acc.end(), 0.f);
+
+			// Horizontal pass of each contributing source row, accumulated vertically as we go
+			for (int t = 0; t < yTaps.count[y]; t++)
+			{
+				int sy = std::clamp(yTaps.first[y] + t, 0, src.height - 1);
+				float wy = yTaps.weights[size_t(y) * yTaps.maxTaps + t];
+				const Color* srcRow = src.data + src.GetIndex(0, sy);
+
+				for (int x = 0; x < dst.width; x++)
+				{
+					const float* weights = &xTaps.weights[size_t(x) * xTaps.maxTaps];
+					__m128 sum = _mm_setzero_ps();
+					for (int k = 0; k < xTaps.count[x]; k++)
+					{
+						int sx = std::clamp(xTaps.first[x] + k, 0, src.width - 1);
+						sum = _mm_add_ps(sum, _mm_mul_ps(LoadColor(srcRow[sx]), _mm_set1_ps(weights[k])));
+					}
+					__m128 a = _mm_loadu_ps(&acc[size_t(x) * 4]);
+					_mm_storeu_ps(&acc[size_t(x) * 4], _mm_add_ps(a, _mm_mul_ps(sum, _mm_set1_ps(wy))));
+				}
+			}
+
+			// Round, clamp and pack back to 8 bits, Lanczos lobes can overshoot either way
+			Color* dstRow = dst.data + dst.GetIndex(0, y);
+			for (int x = 0; x < dst.width; x++)
+			{
+				__m128i px = _mm_cvtps_epi32(_mm_loadu_ps(&acc[size_t(x) * 4]));
+				px = _mm_packs_epi32(px, px);
+				px = _mm_packus_epi16(px, px);
+				int bits = _mm_cvtsi128_si32(px);
+				std::memcpy(&dstRow[x], &bits, sizeof(bits));
+			}
+		}
+	}
+
+	// Exact 2x2 average, 4 output pixels per iteration
+	static void HalveRows_SSE2(const Bitmap& src, Bitmap& dst, int y0, int y1)
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i two = _mm_set1_epi16(2);
+
+		for (int y = y0; y < y1; y++)
+		{
+			const Color* row0 = src.data + src.GetIndex(0, y * 2);
+			const Color* row1 = src.data + src.GetIndex(0, y * 2 + 1);
+			Color* out = dst.data + dst.GetIndex(0, y);
+
+			int x = 0;
+			for (; x + 4 <= dst.width; x += 4)
+			{
+				__m128i a0 = _mm_loadu_si128((const __m128i*)(row0 + x * 2));
+				__m128i a1 = _mm_loadu_si128((const __m128i*)(row0 + x * 2 + 4));
+				__m128i b0 = _mm_loadu_si128((const __m128i*)(row1 + x * 2));
+				__m128i b1 = _mm_loadu_si128((const __m128i*)(row1 + x * 2 + 4));
+
+				// Vertical sums in 16 bits, then add neighbouring pixel pairs
+				__m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+				__m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+				__m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+				__m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+				__m128i hi = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+				lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+				hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+				_mm_storeu_si128((__m128i*)(out + x), _mm_packus_epi16(lo, hi));
+			}
+			for (; x < dst.width; x++)
+			{
+				const Color* p[4] = { &row0[x * 2], &row0[x * 2 + 1], &row1[x * 2], &row1[x * 2 + 1] };
+				out[x] = {
+					(unsigned char)((p[0]->r + p[1]->r + p[2]->r + p[3]->r + 2) >> 2),
+					(unsigned char)((p[0]->g + p[1]->g + p[2]->g + p[3]->g + 2) >> 2),
+					(unsigned char)((p[0]->b + p[1]->b + p[2]->b + p[3]->b + 2) >> 2),
+					(unsigned char)((p[0]->a + p[1]->a + p[2]->a + p[3]->a + 2) >> 2) };
+			}
+		}
+	}
+
+	static void ForEachBand(int rows, ThreadPool* pool, const std::function<void(int, int)>& body)
+	{
+		int bands = (rows + bandRows - 1) / bandRows;
+		auto run = [&](int band) { body(band * bandRows, std::min((band + 1) * bandRows, rows)); };
+		if (pool == nullptr || bands == 1)
+		{
+			for (int band = 0; band < bands; band++)
+				run(band);
+			return;
+		}
+		pool->ParallelFor(bands, run);
+	}
+
+	int Bitmap::MipLevelCount(int width, int height)
+	{
+		int levels = 1;
+		while (width > 1 || height > 1)
+		{
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+			levels++;
+		}
+		return levels;
+	}
+
+	Bitmap Bitmap::Resample(int width, int height, ResampleFilter filter, ThreadPool* pool) const
+	{
+		if (format != PixelFormat::RGBA8)
+			throw std::runtime_error("Bitmap Error: Resampling requires an RGBA8 bitmap\n");
+		Bitmap result(width, height);
+		if (filter == ResampleFilter::Box && width * 2 <= this->width && height * 2 <= this->height && this->width < (width + 1) * 2 && this->height < (height + 1) * 2)
+		{
+			ForEachBand(height, pool, [&](int y0, int y1) { HalveRows_SSE2(*this, result, y0, y1); });
+			return result;
+		}
+
+		FilterTaps xTaps = BuildTaps(this->width, width, filter);
+		FilterTaps yTaps = BuildTaps(this->height, height, filter);
+		ForEachBand(height, pool, [&](int y0, int y1) { ResampleRows(*this, result, xTaps, yTaps, y0, y1); });
+		return result;
+	}
+
+	std::vector<Bitmap> Bitmap::GenMipChain(ResampleFilter filter, ThreadPool& pool) const
+	{
+		// Levels 1..n, each filtered from the previous one; rows of a level are split across the pool
+		std::vector<Bitmap> levels;
+		const Bitmap* previous = this;
+		while (previous->width > 1 || previous->height > 1)
+		{
+			levels.push_back(previous->Resample(std::max(previous->width / 2, 1), std::max(previous->height / 2, 1), filter, &pool));
+			previous = &levels.back();
+		}
+		return levels;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "SimView.hpp"
+#include <tuple>
+
+namespace SimView
+{
+	static std::map<SamplerState, GLuint> samplerObjects;
+
+	// Texture and sampler names the context currently has bound to each unit
+	static GLuint boundTextures[TextureBindings::MaxUnits] = {};
+	static GLuint boundSamplers[TextureBindings::MaxUnits] = {};
+
+	bool SamplerState::operator<(const SamplerState& other) const
+	{
+		return std::tie(minFilter, magFilter, wrapS, wrapT, maxAnisotropy, lodBias)
+			< std::tie(other.minFilter, other.magFilter, other.wrapS, other.wrapT, other.maxAnisotropy, other.lodBias);
+	}
+
+	GLuint SamplerCache::Get(const SamplerState& state)
+	{
+		auto it = samplerObjects.find(state);
+		if (it != samplerObjects.end())
+			return it->second;
+
+		GLuint sampler;
+		glCreateSamplers(1, &sampler);
+		glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, state.minFilter);
+		glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, state.magFilter);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, state.wrapS);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, state.wrapT);
+		glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, state.lodBias);
+		if (state.maxAnisotropy > 1.0f)
+			glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, state.maxAnisotropy);
+
+		samplerObjects[state] = sampler;
+		return sampler;
+	}
+
+	int SamplerCache::GetCount()
+	{
+		return (int)samplerObjects.size();
+	}
+
+	void SamplerCache::Clear()
+	{
+		for (auto& [state, sampler] : samplerObjects)
+			glDeleteSamplers(1, &sampler);
+		samplerObjects.clear();
+		TextureBindings::Invalidate();
+	}
+
+	void TextureBindings::Set(int unit, const Texture& texture)
+	{
+		Set(unit, texture.id, 0);
+	}
+
+	void TextureBindings::Set(int unit, const Texture& texture, const SamplerState& sampler)
+	{
+		Set(unit, texture.id, SamplerCache::Get(sampler));
+	}
+
+	void TextureBindings::Set(int unit, const TextureArray& texArray)
+	{
+		Set(unit, texArray.id, 0);
+	}
+
+	void TextureBindings::Set(int unit, const TextureArray& texArray, const SamplerState& sampler)
+	{
+		Set(unit, texArray.id, SamplerCache::Get(sampler));
+	}
+
+	void TextureBindings::Set(int unit, GLuint texture, GLuint sampler)
+	{
+		if (unit < 0 || unit >= MaxUnits)
+			throw std::runtime_error("TextureBindings Error: Texture unit out of range\n");
+		textures[unit] = texture;
+		samplers[unit] = sampler;
+		usedUnits = std::max(usedUnits, unit + 1);
+	}
+
+	void TextureBindings::Clear(int unit)
+	{
+		Set(unit, 0, 0);
+	}
+
+	int TextureBindings::Apply() const
+	{
+		// Only the span between the first and last changed unit is rebound, each table in a single call
+		int first = usedUnits, last = -1;
+		int changed = 0;
+		for (int unit = 0; unit < usedUnits; unit++)
+		{
+			if (textures[unit] != boundTextures[unit] || samplers[unit] != boundSamplers[unit])
+			{
+				first = std::min(first, unit);
+				last = unit;
+				changed++;
+			}
+		}
+		if (changed == 0)
+			return 0;
+
+		int count = last - first + 1;
+		glBindTextures(first, count, textures + first);
+		glBindSamplers(first, count, samplers + first);
+		std::copy_n(textures + first, count, boundTextures + first);
+		std::copy_n(samplers + first, count, boundSamplers + first);
+		return changed;
+	}
+
+	void TextureBindings::BindUnit(int unit, GLuint texture, GLuint sampler)
+	{
+		if (boundTextures[unit] != texture)
+		{
+			glBindTextureUnit(unit, texture);
+			boundTextures[unit] = texture;
+		}
+		if (boundSamplers[unit] != sampler)
+		{
+			glBindSampler(unit, sampler);
+			boundSamplers[unit] = sampler;
+		}
+	}
+
+	void TextureBindings::Forget(GLuint texture)
+	{
+		// Deleting a texture unbinds it everywhere, and its name may come back for a new texture
+		for (int unit = 0; unit < MaxUnits; unit++)
+		{
+			if (boundTextures[unit] == texture)
+				boundTextures[unit] = 0;
+		}
+	}
+
+	void TextureBindings::Invalidate()
+	{
+		// Forces the next Apply to rebind everything, for code that changes bindings behind our back
+		std::fill_n(boundTextures, MaxUnits, GLuint(-1));
+		std::fill_n(boundSamplers, MaxUnits, GLuint(-1));
+	}
+}
\ No newline at end of file
@@ -77,18 +77,20 @@ namespace SimView
         glUseProgram(id);
     }
 
+    // The index state set with BindIndexArray belongs to the default VAO, so that's where these draws go
     void ShaderProgram::Draw(GLenum drawCall, GLint index, GLsizei count)
     {
+        Mesh::BindDefault();
         if (hasIndexArray)
         {
             if (instanced)
             {
                 //glDrawElementsInstanced(drawCall, index, count, instanceCount);
-                glDrawElementsInstanced(drawCall, count, GL_UNSIGNED_INT, (void*)0, instanceCount);
+                glDrawElementsInstancedBaseVertex(drawCall, count, indexType, (void*)indexOffset, instanceCount, baseVertex);
             }
             else
             {
-                glDrawElements(drawCall, count, GL_UNSIGNED_INT, (void*)0);
+                glDrawElementsBaseVertex(drawCall, count, indexType, (void*)indexOffset, baseVertex);
             }
         }
         else
@@ -113,19 +115,83 @@ namespace SimView
 
     void ShaderProgram::BindArray(VArray<float>& array, GLint loc)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, array.id);
+        Mesh::BindDefault();
+        // Each attribute uses the binding point of the same index, so SetArrayDivisor keeps working per attribute
         glEnableVertexAttribArray(loc);
-        glVertexAttribPointer(loc, array.elemSize, GL_FLOAT, GL_FALSE, 0, 0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glVertexAttribFormat(loc, array.elemSize, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(loc, loc);
+        glBindVertexBuffer(loc, array.GetBuffer(), array.GetOffset(), array.elemSize * sizeof(float));
     }
 
     void ShaderProgram::BindArray(VArray<int>& array, GLint loc)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, array.id);
+        Mesh::BindDefault();
         glEnableVertexAttribArray(loc);
-        //glVertexAttribIPointer(loc, array.elemSize, GL_INT, GL_FALSE, 0, 0);
-        glVertexAttribIPointer(loc, array.elemSize, GL_INT, 0, 0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glVertexAttribIFormat(loc, array.elemSize, GL_INT, 0);
+        glVertexAttribBinding(loc, loc);
+        glBindVertexBuffer(loc, array.GetBuffer(), array.GetOffset(), array.elemSize * sizeof(int));
+    }
+
+    void ShaderProgram::BindArray(StreamVArray<float>& array, GLint loc)
+    {
+        Mesh::BindDefault();
+        glEnableVertexAttribArray(loc);
+        glVertexAttribFormat(loc, array.elemSize, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(loc, loc);
+        glBindVertexBuffer(loc, array.id, array.GetOffset(), array.elemSize * sizeof(float));
+    }
+
+    void ShaderProgram::BindArray(StreamVArray<int>& array, GLint loc)
+    {
+        Mesh::BindDefault();
+        glEnableVertexAttribArray(loc);
+        glVertexAttribIFormat(loc, array.elemSize, GL_INT, 0);
+        glVertexAttribBinding(loc, loc);
+        glBindVertexBuffer(loc, array.id, array.GetOffset(), array.elemSize * sizeof(int));
+    }
+
+    // Binds the whole heap buffer, so arrays from the same block share one binding; draw with array.GetFirst() as the index
+    void ShaderProgram::BindHeapArray(VArray<float>& array, GLint loc)
+    {
+        Mesh::BindDefault();
+        glEnableVertexAttribArray(loc);
+        glVertexAttribFormat(loc, array.elemSize, GL_FLOAT, GL_FALSE, 0);
+        glVertexAttribBinding(loc, loc);
+        glBindVertexBuffer(loc, array.GetBuffer(), 0, array.elemSize * sizeof(float));
+    }
+
+    void ShaderProgram::BindHeapArray(VArray<int>& array, GLint loc)
+    {
+        Mesh::BindDefault();
+        glEnableVertexAttribArray(loc);
+        glVertexAttribIFormat(loc, array.elemSize, GL_INT, 0);
+        glVertexAttribBinding(loc, loc);
+        glBindVertexBuffer(loc, array.GetBuffer(), 0, array.elemSize * sizeof(int));
+    }
+
+    // All attributes of the layout share the binding point of the first location, so SetArrayDivisor takes that location
+    void ShaderProgram::BindLayout(GLuint buffer, size_t offset, const VertexLayout& layout, const std::vector<GLint>& locs)
+    {
+        GLint binding = -1;
+        for (GLint loc : locs)
+        {
+            if (loc >= 0)
+            {
+                binding = loc;
+                break;
+            }
+        }
+        if (binding < 0)
+            return;
+
+        Mesh::BindDefault();
+        Mesh::SetFormat(Mesh::GetDefault(), binding, layout, locs);
+        glBindVertexBuffer(binding, buffer, offset, GLsizei(layout.stride));
+    }
+
+    void ShaderProgram::BindMesh(const Mesh& mesh)
+    {
+        mesh.Bind();
     }
 
     void ShaderProgram::SetInstanceCount(int count)
@@ -136,34 +202,56 @@ namespace SimView
 
     void ShaderProgram::SetArrayDivisor(int divisor, GLint loc)
     {
-        glVertexAttribDivisor(loc, divisor);
+        Mesh::BindDefault();
+        glVertexBindingDivisor(loc, divisor);
+    }
+
+    void ShaderProgram::SetBaseVertex(GLint base)
+    {
+        baseVertex = base;
     }
 
     void ShaderProgram::BindTexture(const Texture& texture)
     {
-        glBindTexture(GL_TEXTURE_2D, texture.id);
+        TextureBindings::BindUnit(0, texture.id, 0);
     }
 
     void ShaderProgram::BindTextureArray(const TextureArray& textureArray)
     {
-        glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.id);
+        TextureBindings::BindUnit(0, textureArray.id, 0);
+    }
+
+    void ShaderProgram::BindTextures(const TextureBindings& bindings)
+    {
+        bindings.Apply();
+    }
+
+    void ShaderProgram::BindTextureUnit(int unit, GLint loc)
+    {
+        glUniform1i(loc, unit);
     }
 
     void ShaderProgram::BindIndexArray(IndexArray& array)
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, array.id);
+        Mesh::BindDefault();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, array.GetBuffer());
+        indexOffset = array.GetOffset();
+        indexType = array.type;
         hasIndexArray = true;
     }
 
     void ShaderProgram::UnbindIndexArray()
     {
+        Mesh::BindDefault();
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        indexOffset = 0;
         hasIndexArray = false;
     }
 
     void ShaderProgram::BindColor(Color color, GLint loc)
     {
-        glUniform4f(loc, color.r / 255.f, color.g / 255.f, color.b / 255.f, color.a / 255.f);
+        FColor fColor = FColor::Convert(color);
+        glUniform4f(loc, fColor.r, fColor.g, fColor.b, fColor.a);
     }
 
     void ShaderProgram::BindMat2x2(glm::mat2x2 matrix, GLint loc)
@@ -225,4 +313,24 @@ namespace SimView
     {
         Draw(GL_POINTS, index, count);
     }
+
+    void ShaderProgram::RenderMesh(const Mesh& mesh, GLenum drawCall)
+    {
+        // Drawn from the mesh's own index state with base vertex 0, the program's index state is left alone
+        mesh.Bind();
+        if (mesh.indexBuffer != 0)
+        {
+            if (instanced)
+                glDrawElementsInstanced(drawCall, mesh.indexCount, mesh.indexType, (void*)mesh.indexOffset, instanceCount);
+            else
+                glDrawElements(drawCall, mesh.indexCount, mesh.indexType, (void*)mesh.indexOffset);
+        }
+        else
+        {
+            if (instanced)
+                glDrawArraysInstanced(drawCall, 0, mesh.vertexCount, instanceCount);
+            else
+                glDrawArrays(drawCall, 0, mesh.vertexCount);
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "SimView.hpp"
+
+namespace SimView
+{
+	static std::mutex statsMutex;
+	static BufferShareStats shareStats;
+
+	SharedBuffer::SharedBuffer(size_t size, const void* data)
+	{
+		this->size = size;
+		glCreateBuffers(1, &id);
+		glNamedBufferStorage(id, size, data, GL_DYNAMIC_STORAGE_BIT);
+		this->allocation = GpuAllocation(GpuResourceType::VertexBuffer, size);
+	}
+
+	SharedBuffer::SharedBuffer(BufferHeap& heap, size_t size, size_t alignment, const void* data)
+	{
+		this->size = size;
+		this->alignment = alignment;
+		this->heap = heap.GetRef();
+		this->slice = heap.Allocate(size, alignment);
+		if (data != nullptr)
+			heap.Write(slice, 0, size, data);
+	}
+
+	SharedBuffer::~SharedBuffer()
+	{
+		if (id != 0)
+		{
+			glDeleteBuffers(1, &id);
+		}
+		heap.Free(slice);
+	}
+
+	GLuint SharedBuffer::GetBuffer() const
+	{
+		return heap ? heap->GetSlice(slice).buffer : id;
+	}
+
+	size_t SharedBuffer::GetOffset() const
+	{
+		return heap ? heap->GetSlice(slice).offset : 0;
+	}
+
+	// Heap storage clones into the same heap
+	std::shared_ptr<SharedBuffer> SharedBuffer::Clone() const
+	{
+		std::shared_ptr<SharedBuffer> copy;
+		if (heap)
+			copy = std::make_shared<SharedBuffer>(*heap.Get(), size, alignment, nullptr);
+		else
+			copy = std::make_shared<SharedBuffer>(size, nullptr);
+		glCopyNamedBufferSubData(GetBuffer(), copy->GetBuffer(), GetOffset(), copy->GetOffset(), size);
+		copy->SetLabel(allocation.label);
+		return copy;
+	}
+
+	// Called by the copy that is about to write, the others keep this buffer
+	std::shared_ptr<SharedBuffer> SharedBuffer::Split()
+	{
+		RecordSplit(size);
+		splits++;
+		return Clone();
+	}
+
+	void SharedBuffer::SetLabel(std::string label)
+	{
+		if (id != 0)
+			glObjectLabel(GL_BUFFER, id, -1, label.c_str());
+		allocation.SetLabel(label);
+	}
+
+	void SharedBuffer::RecordShare(size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		shareStats.copiesAvoided++;
+		shareStats.bytesAvoided += bytes;
+	}
+
+	// A share that ended in a device copy after all no longer counts as avoided
+	void SharedBuffer::RecordSplit(size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		if (shareStats.copiesAvoided > 0)
+			shareStats.copiesAvoided--;
+		shareStats.bytesAvoided -= std::min(shareStats.bytesAvoided, bytes);
+		shareStats.deferredCopies++;
+	}
+
+	BufferShareStats SharedBuffer::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		return shareStats;
+	}
+
+	void SharedBuffer::ResetStats()
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		shareStats = BufferShareStats();
+	}
+}
\ No newline at end of file
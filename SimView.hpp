@@ -7,26 +7,149 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <string>
+#include <cstring>
 #include <stdexcept>
 #include <vector>
 #include <map>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <type_traits>
 
 namespace SimView
 {
 	typedef std::uint8_t u8;
-	typedef std::uint8_t u16;
-	typedef std::uint8_t u32;
+	typedef std::uint16_t u16;
+	typedef std::uint32_t u32;
 	typedef std::int8_t i8;
-	typedef std::int8_t i16;
-	typedef std::int8_t i32;
+	typedef std::int16_t i16;
+	typedef std::int32_t i32;
 
 	class Core
 	{
 	public:
 		static void Init();
 		static void DeInit();
+
+		static bool HasSSE2();
+		static bool HasAVX2();
+		static bool HasF16C();
+	};
+
+	enum class PixelFormat
+	{
+		R8,
+		RG8,
+		RGBA8,
+		R16F,
+		RG16F,
+		RGBA16F,
+		R32F,
+		RG32F,
+		RGBA32F,
+	};
+
+	struct PixelFormatInfo
+	{
+		int bytes;
+		int channels;
+		bool isFloat;
+		GLenum internalFormat;
+		GLenum format;
+		GLenum type;
+
+		static const PixelFormatInfo& Get(PixelFormat format);
+		int UnpackAlignment(int width) const;
+	};
+
+	class Half
+	{
+	public:
+		std::uint16_t bits;
+
+		static Half FromFloat(float value);
+		float ToFloat() const;
+
+		static void FromFloats(const float* src, Half* dst, size_t count);
+		static void ToFloats(const Half* src, float* dst, size_t count);
+	};
+
+	class Half2
+	{
+	public:
+		Half x;
+		Half y;
+
+		static Half2 FromVec(glm::vec2 value);
+	};
+
+	class Half4
+	{
+	public:
+		Half x;
+		Half y;
+		Half z;
+		Half w;
+
+		static Half4 FromVec(glm::vec4 value);
+	};
+
+	// Signed normalized 10/10/10/2 bits, matching GL_INT_2_10_10_10_REV
+	class Packed1010102
+	{
+	public:
+		std::uint32_t bits;
+
+		static Packed1010102 FromVec(glm::vec4 value);
+	};
+
+	enum class ResampleFilter
+	{
+		Box,
+		Bilinear,
+		Lanczos,
+	};
+
+	class ThreadPool
+	{
+	public:
+		ThreadPool(int threadCount = 0);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		~ThreadPool();
+
+		static ThreadPool& Shared();
+		int GetThreadCount() const;
+		void Submit(std::function<void()> task);
+		void ParallelFor(int count, const std::function<void(int)>& body);
+		void Wait();
+
+	private:
+		std::vector<std::thread> threads;
+		std::deque<std::function<void()>> tasks;
+		std::mutex mutex;
+		std::condition_variable taskCv;
+		std::condition_variable idleCv;
+		int activeTasks = 0;
+		bool stopping = false;
+
+		void WorkerLoop();
+	};
+
+	enum class BlendMode
+	{
+		Default,
+		Alpha,
+		PreMultAlpha,
+		Add,
 	};
 
+	class FColor;
+
 	class Color
 	{
 	public:
@@ -40,6 +163,17 @@ namespace SimView
 		static Color Red(float alpha) { return { 255,  0,  0,unsigned char(alpha * 255) }; };
 		static Color Green(float alpha) { return { 0,255,  0,unsigned char(alpha * 255) }; };
 		static Color Blue(float alpha) { return { 0,  0,255,unsigned char(alpha * 255) }; };
+
+		static Color Blend(Color src, Color dst, BlendMode mode);
+
+		// Bulk conversion functions
+
+		static void ConvertArray(const FColor* src, Color* dst, size_t count);
+		static void ConvertSrgbArray(const FColor* src, Color* dst, size_t count);
+		static void SrgbToLinear(const Color* src, Color* dst, size_t count);
+		static void LinearToSrgb(const Color* src, Color* dst, size_t count);
+		static void Premultiply(Color* data, size_t count);
+		static void Unpremultiply(Color* data, size_t count);
 	};
 
 	class FColor
@@ -52,9 +186,13 @@ namespace SimView
 
 		static FColor Convert(Color color)
 		{
-			return { color.r / 255.f,color.g / 255.f ,color.b / 255.f ,color.a / 255.f };
+			const float scale = 1.f / 255.f;
+			return { color.r * scale,color.g * scale ,color.b * scale ,color.a * scale };
 		}
 
+		static void ConvertArray(const Color* src, FColor* dst, size_t count);
+		static void ConvertSrgbArray(const Color* src, FColor* dst, size_t count);
+
 		static FColor Black(float alpha) { return { 0,  0,  0, alpha }; };
 		static FColor White(float alpha) { return { 1,  1,  1, alpha }; };
 		static FColor Red(float alpha) { return { 1,  0,  0, alpha }; };
@@ -62,95 +200,927 @@ namespace SimView
 		static FColor Blue(float alpha) { return { 0,  0,  1, alpha }; };
 	};
 
-	class Bitmap
+	class BitmapPool
 	{
 	public:
-		Color* data = nullptr;
+		static const size_t Alignment = 64;
+
+		static void* Allocate(size_t bytes);
+		static void* Reallocate(void* ptr, size_t bytes);
+		static void Free(void* ptr);
+		static size_t GetCapacity(void* ptr);
+
+		static void SetLargePages(bool enabled);
+		// Freed blocks past this many bytes are returned to the system, largest first
+		static void SetCacheBudget(size_t bytes);
+		static void Trim();
+		static size_t GetCachedBytes();
+		static size_t GetHeapAllocations();
+	};
+
+	class MappedFile
+	{
+	public:
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+
+		MappedFile() {};
+		MappedFile(std::string path);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		~MappedFile();
+
+		void Close();
+	};
+
+	enum class GpuResourceType
+	{
+		Texture,
+		TextureArray,
+		VertexBuffer,
+		IndexBuffer,
+		PixelBuffer,
+	};
+
+	struct GpuMemoryStats
+	{
+		size_t liveBytes = 0;
+		size_t peakBytes = 0;
+		int liveCount = 0;
+	};
+
+	class GpuMemory
+	{
+	public:
+		static const int TypeCount = 5;
+
+		static void Record(GpuResourceType type, const std::string& label, std::int64_t bytes, int count);
+		static GpuMemoryStats GetTotal();
+		static GpuMemoryStats GetStats(GpuResourceType type);
+		static GpuMemoryStats GetStats(const std::string& label);
+		static std::map<std::string, GpuMemoryStats> GetLabelStats();
+		static const char* GetTypeName(GpuResourceType type);
+		static size_t GetTextureBytes(GLenum internalFormat, int width, int height, int levels, int layers = 1);
+	};
+
+	class GpuAllocation
+	{
+	public:
+		GpuResourceType type = GpuResourceType::Texture;
+		std::string label;
+		size_t bytes = 0;
+		bool active = false;
+
+		GpuAllocation() {};
+		GpuAllocation(GpuResourceType type, size_t bytes, std::string label = "");
+		GpuAllocation(const GpuAllocation&) = delete;
+		GpuAllocation& operator=(const GpuAllocation&) = delete;
+		GpuAllocation(GpuAllocation&& other) noexcept;
+		GpuAllocation& operator=(GpuAllocation&& other) noexcept;
+		~GpuAllocation();
+
+		void Resize(size_t bytes);
+		void SetLabel(std::string label);
+		void Release();
+	};
+
+	struct Rect
+	{
+		int x;
+		int y;
 		int width;
 		int height;
+	};
+
+	struct ImageLoadStats
+	{
+		int imageCount = 0;
+		size_t bytesRead = 0;
+		double decodeSeconds = 0;
+	};
+
+	class Bitmap;
+
+	class BitmapView
+	{
+	public:
+		Color* data = nullptr;
+		int width = 0;
+		int height = 0;
+		int stride = 0;
+
+		BitmapView() {};
+		BitmapView(Color* data, int width, int height, int stride);
+		BitmapView(const Bitmap& bitmap);
+		int GetIndex(int x, int y) const;
+
+		BitmapView SubView(int x, int y, int width, int height) const;
+		Color GetPixel(int x, int y) const;
+		void SetPixel(int x, int y, Color color);
+		void DrawBitmap(int oX, int oY, const BitmapView& img);
+		void DrawBitmap(int oX, int oY, const BitmapView& img, BlendMode mode);
+	};
+
+	class Bitmap
+	{
+	public:
+		Color* data = nullptr;
+		int width = 0;
+		int height = 0;
+		PixelFormat format = PixelFormat::RGBA8;
+		bool ownsData = true;
+
+		// Dirty region tracking
+		static const int MaxDirtyRects = 32;
+		std::vector<Rect> dirtyRects;
+		std::vector<std::uint64_t> tileHashes;
+		int hashTileSize = 0;
 
-		Bitmap(int width, int height, Color* data);
+		Bitmap() {};
+		Bitmap(int width, int height);
+		Bitmap(int width, int height, PixelFormat format);
+		Bitmap(int width, int height, const Color* data);
+		Bitmap(const Bitmap& other);
+		Bitmap(Bitmap&& other) noexcept;
+		Bitmap& operator=(const Bitmap& other);
+		Bitmap& operator=(Bitmap&& other) noexcept;
+		~Bitmap();
 		int GetIndex(int x, int y) const;
 
 		static Bitmap GetColorImage(int width, int height, Color color);
-		static Bitmap FromFile(std::string path);
+		static Bitmap Wrap(void* data, int width, int height, PixelFormat format = PixelFormat::RGBA8);
+		static Bitmap FromFile(std::string path, ImageLoadStats* stats = nullptr);
+		static Bitmap FromFile(std::string path, PixelFormat format, ImageLoadStats* stats = nullptr);
+		static Bitmap FromMemory(const void* fileData, size_t size, ImageLoadStats* stats = nullptr);
+		static Bitmap FromMemory(const void* fileData, size_t size, PixelFormat format, ImageLoadStats* stats = nullptr);
+		static ImageLoadStats GetTotalLoadStats();
+		static int MipLevelCount(int width, int height);
+		Bitmap Resample(int width, int height, ResampleFilter filter, ThreadPool* pool = nullptr) const;
+		std::vector<Bitmap> GenMipChain(ResampleFilter filter = ResampleFilter::Box, ThreadPool& pool = ThreadPool::Shared()) const;
+		void Resize(int width, int height);
+		int GetPixelSize() const;
+		size_t GetByteSize() const;
+		template <typename T> T* As() const { return (T*)data; }
+		BitmapView GetView() const;
+		BitmapView GetView(int x, int y, int width, int height) const;
 		Color GetPixel(int x, int y) const; 
 		void SetPixel(int x, int y, Color color);
-		void DrawBitmap(int oX, int oY, const Bitmap& img);
-		~Bitmap();
+		void DrawBitmap(int oX, int oY, const BitmapView& img);
+		void DrawBitmap(int oX, int oY, const BitmapView& img, BlendMode mode);
+
+		void MarkDirty(int x, int y, int width, int height);
+		void MarkAllDirty();
+		void ClearDirty();
+		void EnableTileHashing(int tileSize = 64);
+		void DisableTileHashing();
+		void DetectChanges(ThreadPool* pool = nullptr);
+		std::vector<Rect> TakeDirtyRects();
+	};
+
+	class SoftRasterizer
+	{
+	public:
+		static const int TileSize = 64;
+
+		SoftRasterizer(Bitmap& target, ThreadPool& pool = ThreadPool::Shared());
+
+		// Settings functions
+
+		void SetBlendMode(BlendMode mode);
+		void SetColor(Color color);
+		void SetTexture(const Bitmap* texture);
+		void SetLineWidth(float width);
+		void SetPointSize(float size);
+
+
+		// Rendering functions, positions are in normalized device coordinates like a vertex shader's output
+
+		void FillScreen(Color color);
+		void RenderTri(const glm::vec2* positions, const glm::vec2* uvs = nullptr);
+		void RenderTris(int count, const glm::vec2* positions, const glm::vec2* uvs = nullptr);
+		void RenderQuad(const glm::vec2* positions, const glm::vec2* uvs = nullptr);
+		void RenderLine(const glm::vec2* positions);
+		void RenderLines(int count, const glm::vec2* positions);
+		void RenderPoints(int count, const glm::vec2* positions);
+		void Flush();
+
+	private:
+		struct Triangle
+		{
+			glm::vec2 p[3];
+			glm::vec2 uv[3];
+			Color color;
+			const Bitmap* texture;
+			BlendMode mode;
+		};
+
+		Bitmap* target;
+		ThreadPool* pool;
+		std::vector<Triangle> triangles;
+		BlendMode mode = BlendMode::Default;
+		Color color = { 255,255,255,255 };
+		const Bitmap* texture = nullptr;
+		float lineWidth = 1;
+		float pointSize = 1;
+
+		glm::vec2 ToScreen(glm::vec2 ndc) const;
+		void AddTriangle(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 uvA, glm::vec2 uvB, glm::vec2 uvC);
+		void RasterizeTile(const std::vector<int>& bin, int tileX, int tileY) const;
+	};
+
+	enum class BlockFormat
+	{
+		BC1,
+		BC3,
+		BC7,
+	};
+
+	enum class CompressionQuality
+	{
+		Fast,
+		Normal,
+		High,
+	};
+
+	struct CompressionStats
+	{
+		double psnr = 0;
+		double seconds = 0;
+		size_t inputBytes = 0;
+		size_t outputBytes = 0;
+	};
+
+	class CompressedImage
+	{
+	public:
+		BlockFormat format = BlockFormat::BC1;
+		int width = 0;
+		int height = 0;
+		std::vector<std::vector<unsigned char>> levels;
+
+		CompressedImage() {};
+
+		static CompressedImage Encode(const Bitmap& image, BlockFormat format, CompressionQuality quality = CompressionQuality::Normal, bool mipmaps = true, CompressionStats* stats = nullptr, ThreadPool& pool = ThreadPool::Shared());
+		static std::vector<unsigned char> EncodeLevel(const Bitmap& image, BlockFormat format, CompressionQuality quality = CompressionQuality::Normal, ThreadPool& pool = ThreadPool::Shared());
+		static Bitmap DecodeLevel(const unsigned char* data, int width, int height, BlockFormat format);
+		static double ComputePsnr(const Bitmap& a, const Bitmap& b);
+		static GLenum GetInternalFormat(BlockFormat format);
+		static int GetBlockBytes(BlockFormat format);
+		static size_t GetLevelSize(BlockFormat format, int width, int height);
+
+		GLenum GetInternalFormat() const;
+		Bitmap Decode(int level = 0) const;
 	};
 
 	class TextureArray
 	{
 	public:
-		GLuint id;
+		GLuint id = 0;
+		int width = 0;
+		int height = 0;
+		int layers = 0;
+		int levels = 0;
+		PixelFormat format = PixelFormat::RGBA8;
+		GLenum internalFormat = GL_RGBA8;
+		GpuAllocation allocation;
+
+		TextureArray() {};
+		TextureArray(int width, int height, int layers, int mipLevel, PixelFormat format = PixelFormat::RGBA8);
+		TextureArray(int width, int height, int layers, int mipLevel, GLenum internalFormat);
+		TextureArray(const TextureArray&) = delete;
+		TextureArray& operator=(const TextureArray&) = delete;
+		TextureArray(TextureArray&& other) noexcept;
+		TextureArray& operator=(TextureArray&& other) noexcept;
+		~TextureArray();
 
-		TextureArray();
-		TextureArray(int width, int height, int layers, int mipLevel);
+		void SetLabel(std::string label);
+		void Destroy();
 		void LayerFromBitmap(Bitmap& image, int layer);
+		void SetLayerLevel(int layer, int level, const Bitmap& image);
+		void LayerFromMipChain(const Bitmap& image, const std::vector<Bitmap>& mips, int layer);
+		void UpdateLayer(Bitmap& image, int layer);
+		void LayerFromCompressed(const CompressedImage& image, int layer);
 		void GenMipmaps(float bias);
 	};
 
+	struct BatchLoaderState;
+
+	class BatchLoader
+	{
+	public:
+		BatchLoader(TextureArray& target, std::vector<std::string> paths, int firstLayer = 0, ThreadPool& pool = ThreadPool::Shared());
+		BatchLoader(const BatchLoader&) = delete;
+		BatchLoader& operator=(const BatchLoader&) = delete;
+		~BatchLoader();
+
+		int Poll(int maxUploads = -1);
+		void Finish(std::function<void(int uploaded, int total)> progress = nullptr);
+		void Cancel();
+
+		bool IsDone() const;
+		bool IsCancelled() const;
+		int GetDecodedCount() const;
+		int GetUploadedCount() const;
+		int GetTotal() const;
+		float GetProgress() const;
+
+	private:
+		TextureArray* target;
+		int firstLayer;
+		std::shared_ptr<BatchLoaderState> state;
+	};
+
+	struct VirtualTextureState;
+
+	class VirtualTexture
+	{
+	public:
+		static const int FallbackLayer = 0;
+
+		TextureArray layers;
+		GLuint indirection = 0;
+		GpuAllocation indirectionAllocation;
+
+		VirtualTexture(int tileWidth, int tileHeight, int layerBudget, std::vector<std::string> tilePaths, int mipLevels = 1, ThreadPool& pool = ThreadPool::Shared());
+		VirtualTexture(const VirtualTexture&) = delete;
+		VirtualTexture& operator=(const VirtualTexture&) = delete;
+		~VirtualTexture();
+
+		void SetFallback(const Bitmap& image);
+		void Request(int tileId);
+		int Update(int maxUploads = -1);
+		void BindIndirection(GLuint binding) const;
+
+		bool IsResident(int tileId) const;
+		int GetLayer(int tileId) const;
+		int GetTileCount() const;
+		int GetResidentCount() const;
+		int GetPendingCount() const;
+
+	private:
+		struct Tile
+		{
+			int layer = FallbackLayer;
+			bool loading = false;
+			bool failed = false;
+			std::list<int>::iterator lruEntry;
+		};
+
+		int tileWidth;
+		int tileHeight;
+		int pending = 0;
+		ThreadPool* pool;
+		std::vector<Tile> tiles;
+		std::vector<int> freeLayers;
+		std::list<int> lru;
+		std::vector<std::int32_t> table;
+		int dirtyBegin = 0;
+		int dirtyEnd = 0;
+		std::shared_ptr<VirtualTextureState> state;
+
+		void UploadTile(int layer, Bitmap& image, const std::vector<Bitmap>& mips);
+		int AcquireLayer();
+	};
+
 	class Texture
 	{
 	public:
-		GLuint id;
+		GLuint id = 0;
+		int width = 0;
+		int height = 0;
+		int levels = 0;
+		GLenum internalFormat = GL_RGBA8;
+		GpuAllocation allocation;
 
-		Texture();
+		Texture() {};
 		Texture(GLuint id) : id(id) {};
 		Texture(int width, int height, Color* data);
+		Texture(int width, int height, PixelFormat format, const void* data, int mipLevels = 1);
+		Texture(int width, int height, int mipLevels, GLenum internalFormat);
+		Texture(const Texture&) = delete;
+		Texture& operator=(const Texture&) = delete;
+		Texture(Texture&& other) noexcept;
+		Texture& operator=(Texture&& other) noexcept;
+		~Texture();
+
+		void SetLabel(std::string label);
+		void Destroy();
+		void SetLevel(int level, const Bitmap& image);
+		void Update(Bitmap& image);
 		void GenMipmaps(int maxLod, float bias);
 
 		static Texture FromBitmap(Bitmap& image);
+		static Texture FromMipChain(const Bitmap& image, const std::vector<Bitmap>& mips);
+		static Texture FromCompressed(const CompressedImage& image);
 		static Texture FromTextureArray(TextureArray& texArray, int layer);
 	};
 
+	struct SamplerState
+	{
+		GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+		GLenum magFilter = GL_NEAREST;
+		GLenum wrapS = GL_CLAMP_TO_BORDER;
+		GLenum wrapT = GL_CLAMP_TO_BORDER;
+		float maxAnisotropy = 1.0f;
+		float lodBias = 0.0f;
+
+		bool operator<(const SamplerState& other) const;
+	};
+
+	class SamplerCache
+	{
+	public:
+		static GLuint Get(const SamplerState& state);
+		static int GetCount();
+		static void Clear();
+	};
+
+	class TextureBindings
+	{
+	public:
+		static const int MaxUnits = 32;
+
+		void Set(int unit, const Texture& texture);
+		void Set(int unit, const Texture& texture, const SamplerState& sampler);
+		void Set(int unit, const TextureArray& texArray);
+		void Set(int unit, const TextureArray& texArray, const SamplerState& sampler);
+		void Set(int unit, GLuint texture, GLuint sampler);
+		void Clear(int unit);
+		int Apply() const;
+
+		static void BindUnit(int unit, GLuint texture, GLuint sampler);
+		static void Forget(GLuint texture);
+		static void Invalidate();
+
+	private:
+		GLuint textures[MaxUnits] = {};
+		GLuint samplers[MaxUnits] = {};
+		int usedUnits = 0;
+	};
+
+	class Fence
+	{
+	public:
+		GLsync sync = nullptr;
+
+		Fence() {};
+		Fence(const Fence&) = delete;
+		Fence& operator=(const Fence&) = delete;
+		Fence(Fence&& other) noexcept;
+		Fence& operator=(Fence&& other) noexcept;
+		~Fence();
+
+		void Set();
+		bool IsSignaled() const;
+		void Wait() const;
+		void Clear();
+	};
+
+	struct AtlasRegion
+	{
+		int page;
+		int x, y, width, height;
+		glm::vec2 uvMin;
+		glm::vec2 uvMax;
+	};
+
+	class TextureAtlas
+	{
+	public:
+		int width = 0;
+		int height = 0;
+		int padding = 0;
+		std::vector<Bitmap> pages;
+		std::vector<AtlasRegion> regions;
+
+		TextureAtlas(int width, int height, int padding = 2);
+		int Add(const Bitmap& image);
+		const AtlasRegion& GetRegion(int index) const;
+		int GetPageCount() const;
+		float GetOccupancy() const;
+
+		// Building and incremental uploads, only regions added since the last upload are sent
+
+		Texture BuildTexture(int page = 0);
+		TextureArray BuildTextureArray(int layers, int mipLevels = 1);
+		void Update(Texture& texture, int page = 0);
+		void Update(TextureArray& texArray);
+
+	private:
+		struct SkylineNode
+		{
+			int x, y, width;
+		};
+
+		std::vector<std::vector<SkylineNode>> skylines;
+		std::vector<size_t> usedArea;
+
+		bool FindPosition(const std::vector<SkylineNode>& skyline, int width, int height, int& bestX, int& bestY, int& bestIndex) const;
+		void AddLevel(std::vector<SkylineNode>& skyline, int index, int x, int y, int width, int height);
+		void AddPage();
+		void ExtrudeGutter(Bitmap& page, int x, int y, int width, int height);
+	};
+
+	class MappedBitmap
+	{
+	public:
+		static const int BufferCount = 2;
+
+		MappedBitmap(int width, int height, PixelFormat format = PixelFormat::RGBA8);
+		MappedBitmap(const MappedBitmap&) = delete;
+		MappedBitmap& operator=(const MappedBitmap&) = delete;
+		~MappedBitmap();
+
+		Bitmap& GetBitmap();
+		const Bitmap& GetPresented() const;
+		void Present(Texture& texture);
+		void PresentLayer(TextureArray& texArray, int layer);
+
+	private:
+		GLuint buffer = 0;
+		unsigned char* mapped = nullptr;
+		size_t regionBytes = 0;
+		GpuAllocation allocation;
+		int current = 0;
+		Bitmap regions[BufferCount];
+		Fence fences[BufferCount];
+
+		void Swap();
+	};
+
+	enum class UploadStatus
+	{
+		Complete,
+		InFlight,
+	};
+
+	class TextureStreamer
+	{
+	public:
+		TextureStreamer(size_t slotBytes, int slotCount = 3);
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+		~TextureStreamer();
+
+		int Upload(Texture& texture, const Bitmap& image);
+		int UploadLayer(TextureArray& texArray, const Bitmap& image, int layer);
+		UploadStatus GetStatus(int ticket) const;
+		void Finish();
+
+	private:
+		struct Slot
+		{
+			Fence fence;
+			int ticket = -1;
+		};
+
+		GLuint buffer = 0;
+		unsigned char* mapped = nullptr;
+		size_t slotBytes;
+		GpuAllocation allocation;
+		std::vector<Slot> slots;
+		int nextSlot = 0;
+		int nextTicket = 0;
+
+		size_t Stage(const Bitmap& image);
+		int Commit();
+	};
+
+	struct AssetArchiveHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t entryCount;
+		std::uint32_t reserved;
+		std::uint64_t indexOffset;
+		std::uint64_t namesOffset;
+	};
+
+	struct AssetArchiveEntry
+	{
+		static const int MaxLevels = 16;
+
+		std::uint64_t nameOffset;
+		std::uint32_t nameLength;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t levelCount;
+		std::uint32_t internalFormat;
+		std::uint32_t reserved;
+		std::uint64_t levelOffsets[MaxLevels];
+		std::uint64_t levelSizes[MaxLevels];
+	};
+
+	class AssetArchiveWriter
+	{
+	public:
+		void Add(std::string name, const Bitmap& image, bool mipmaps = true, ResampleFilter filter = ResampleFilter::Box);
+		void Add(std::string name, const CompressedImage& image);
+		void AddLevels(std::string name, int width, int height, GLenum internalFormat, std::vector<std::vector<unsigned char>> levels);
+		void Write(std::string path);
+
+	private:
+		struct PendingEntry
+		{
+			std::string name;
+			int width;
+			int height;
+			GLenum internalFormat;
+			std::vector<std::vector<unsigned char>> levels;
+		};
+		std::vector<PendingEntry> entries;
+	};
+
+	class AssetArchive
+	{
+	public:
+		MappedFile file;
+		const AssetArchiveHeader* header = nullptr;
+		const AssetArchiveEntry* entries = nullptr;
+		std::map<std::string, int> index;
+
+		AssetArchive() {};
+		AssetArchive(std::string path);
+
+		bool Contains(std::string name) const;
+		const AssetArchiveEntry& GetEntry(std::string name) const;
+		const unsigned char* GetLevelData(const AssetArchiveEntry& entry, int level) const;
+
+		Bitmap LoadBitmap(std::string name) const;
+		Texture LoadTexture(std::string name) const;
+		void LoadLayer(TextureArray& texArray, std::string name, int layer) const;
+	};
+
+	struct BufferSlice
+	{
+		GLuint buffer = 0;
+		size_t offset = 0;
+		size_t size = 0;
+	};
+
+	class BufferHeap;
+
+	// What slice owners keep instead of a raw heap pointer; the heap clears it when destroyed,
+	// so a late Free is ignored and a late lookup throws instead of touching freed memory
+	class HeapRef
+	{
+	public:
+		HeapRef() {};
+		HeapRef(std::shared_ptr<BufferHeap*> cell) : cell(std::move(cell)) {};
+
+		BufferHeap* Get() const;
+		BufferHeap* operator->() const { return Get(); }
+		explicit operator bool() const { return cell != nullptr; }
+		void Free(int slice) const;
+
+	private:
+		std::shared_ptr<BufferHeap*> cell;
+	};
+
+	class BufferHeap
+	{
+	public:
+		size_t blockSize = 0;
+		size_t alignment = 0;
+		GpuResourceType type = GpuResourceType::VertexBuffer;
+
+		BufferHeap(size_t blockSize = size_t(64) << 20, size_t alignment = 16, GpuResourceType type = GpuResourceType::VertexBuffer);
+		BufferHeap(const BufferHeap&) = delete;
+		BufferHeap& operator=(const BufferHeap&) = delete;
+		~BufferHeap();
+
+		int Allocate(size_t size, size_t alignment = 0);
+		void Free(int handle);
+		const BufferSlice& GetSlice(int handle) const;
+		void Write(int handle, size_t offset, size_t size, const void* data);
+		size_t Defragment(size_t maxBytes);
+		void SetLabel(std::string label);
+
+		int GetBlockCount() const;
+		int GetSliceCount() const;
+		size_t GetCapacity() const;
+		size_t GetUsedBytes() const;
+		size_t GetLargestFreeRange() const;
+		float GetFragmentation() const;
+		HeapRef GetRef() const;
+
+	private:
+		struct Block
+		{
+			GLuint buffer = 0;
+			size_t size = 0;
+			size_t used = 0;
+			std::map<size_t, size_t> freeByOffset;
+			std::multimap<size_t, size_t> freeBySize;
+			std::map<size_t, int> slices;
+			GpuAllocation allocation;
+		};
+		struct Entry
+		{
+			BufferSlice slice;
+			size_t alignment = 0;
+			int block = -1;
+		};
+		std::vector<Block> blocks;
+		std::vector<Entry> entries;
+		std::vector<int> freeHandles;
+		int sliceCount = 0;
+		std::string label;
+		std::shared_ptr<BufferHeap*> self;
+
+		int AddBlock(size_t minSize);
+		void TrimBlocks();
+		bool FindRange(size_t size, size_t alignment, int lastBlock, size_t limit, int& block, size_t& offset) const;
+		void TakeRange(Block& block, size_t offset, size_t size);
+		void ReleaseRange(Block& block, size_t offset, size_t size);
+		void EraseFree(Block& block, size_t offset, size_t size);
+	};
+
+	enum class VertexFormat
+	{
+		Float,
+		Half,
+		UByteNorm,
+		UShortNorm,
+		Int,
+		Packed1010102,
+	};
+
+	struct VertexAttribute
+	{
+		VertexFormat format;
+		int components;
+		size_t offset;
+	};
+
+	// Maps a field type to its vertex format; specialize for other types
 	template <typename T>
-	class VArray
+	struct VertexTraits
+	{
+		static const bool known = false;
+	};
+
+	template <VertexFormat F, int N>
+	struct VertexTraitsOf
+	{
+		static const bool known = true;
+		static const VertexFormat format = F;
+		static const int components = N;
+	};
+
+	template <> struct VertexTraits<float> : VertexTraitsOf<VertexFormat::Float, 1> {};
+	template <> struct VertexTraits<int> : VertexTraitsOf<VertexFormat::Int, 1> {};
+	template <> struct VertexTraits<Half> : VertexTraitsOf<VertexFormat::Half, 1> {};
+	template <> struct VertexTraits<Half2> : VertexTraitsOf<VertexFormat::Half, 2> {};
+	template <> struct VertexTraits<Half4> : VertexTraitsOf<VertexFormat::Half, 4> {};
+	template <> struct VertexTraits<Color> : VertexTraitsOf<VertexFormat::UByteNorm, 4> {};
+	template <> struct VertexTraits<Packed1010102> : VertexTraitsOf<VertexFormat::Packed1010102, 4> {};
+	template <glm::length_t L, glm::qualifier Q> struct VertexTraits<glm::vec<L, float, Q>> : VertexTraitsOf<VertexFormat::Float, L> {};
+	template <glm::length_t L, glm::qualifier Q> struct VertexTraits<glm::vec<L, int, Q>> : VertexTraitsOf<VertexFormat::Int, L> {};
+	template <glm::length_t L, glm::qualifier Q> struct VertexTraits<glm::vec<L, glm::u8, Q>> : VertexTraitsOf<VertexFormat::UByteNorm, L> {};
+	template <glm::length_t L, glm::qualifier Q> struct VertexTraits<glm::vec<L, glm::u16, Q>> : VertexTraitsOf<VertexFormat::UShortNorm, L> {};
+
+	// Aggregate field enumeration through structured bindings, up to 8 fields
+	struct VertexFields
+	{
+		struct Any
+		{
+			template <typename U>
+			operator U() const;
+		};
+
+		template <typename T>
+		static constexpr int Count()
+		{
+			if constexpr (requires { T{ Any(), Any(), Any(), Any(), Any(), Any(), Any(), Any() }; }) return 8;
+			else if constexpr (requires { T{ Any(), Any(), Any(), Any(), Any(), Any(), Any() }; }) return 7;
+			else if constexpr (requires { T{ Any(), Any(), Any(), Any(), Any(), Any() }; }) return 6;
+			else if constexpr (requires { T{ Any(), Any(), Any(), Any(), Any() }; }) return 5;
+			else if constexpr (requires { T{ Any(), Any(), Any(), Any() }; }) return 4;
+			else if constexpr (requires { T{ Any(), Any(), Any() }; }) return 3;
+			else if constexpr (requires { T{ Any(), Any() }; }) return 2;
+			else if constexpr (requires { T{ Any() }; }) return 1;
+			else return 0;
+		}
+
+		template <typename T, typename F>
+		static void ForEach(T& value, F&& func)
+		{
+			constexpr int count = Count<T>();
+			static_assert(count > 0, "VertexFields: type has no fields or more than 8");
+			if constexpr (count == 1) { auto& [a] = value; func(a); }
+			else if constexpr (count == 2) { auto& [a, b] = value; func(a); func(b); }
+			else if constexpr (count == 3) { auto& [a, b, c] = value; func(a); func(b); func(c); }
+			else if constexpr (count == 4) { auto& [a, b, c, d] = value; func(a); func(b); func(c); func(d); }
+			else if constexpr (count == 5) { auto& [a, b, c, d, e] = value; func(a); func(b); func(c); func(d); func(e); }
+			else if constexpr (count == 6) { auto& [a, b, c, d, e, f] = value; func(a); func(b); func(c); func(d); func(e); func(f); }
+			else if constexpr (count == 7) { auto& [a, b, c, d, e, f, g] = value; func(a); func(b); func(c); func(d); func(e); func(f); func(g); }
+			else { auto& [a, b, c, d, e, f, g, h] = value; func(a); func(b); func(c); func(d); func(e); func(f); func(g); func(h); }
+		}
+	};
+
+	class VertexLayout
 	{
 	public:
-		GLuint id;
-		int count;
-		int elemSize;
-		bool hasArray;
+		std::vector<VertexAttribute> attributes;
+		size_t stride = 0;
 
-		VArray()
+		VertexLayout& Add(VertexFormat format, int components);
+		VertexLayout& Add(VertexFormat format, int components, size_t offset);
+
+		static size_t GetSize(VertexFormat format, int components);
+
+		// Deduced from a known vertex type, or from each field of an aggregate in declaration order
+		template <typename T>
+		static VertexLayout Of()
 		{
-			this->hasArray = false;
+			VertexLayout layout;
+			if constexpr (VertexTraits<T>::known)
+			{
+				layout.Add(VertexTraits<T>::format, VertexTraits<T>::components, 0);
+			}
+			else
+			{
+				static_assert(std::is_aggregate_v<T>, "VertexLayout: type is neither a vertex type nor an aggregate");
+				T value{};
+				VertexFields::ForEach(value, [&](auto& field)
+				{
+					typedef std::remove_cvref_t<decltype(field)> Field;
+					static_assert(VertexTraits<Field>::known, "VertexLayout: field type has no vertex format");
+					layout.Add(VertexTraits<Field>::format, VertexTraits<Field>::components, size_t((char*)&field - (char*)&value));
+				});
+			}
+			layout.stride = sizeof(T);
+			return layout;
 		}
+	};
+
+	struct BufferShareStats
+	{
+		size_t copiesAvoided = 0;
+		size_t bytesAvoided = 0;
+		size_t deferredCopies = 0;
+	};
+
+	// Device storage behind a VArray; copies share it and split off on the first write
+	class SharedBuffer
+	{
+	public:
+		GLuint id = 0;
+		HeapRef heap;
+		int slice = -1;
+		size_t size = 0;
+		size_t alignment = 0;
+		// Counts the copies that moved off this buffer with Split, so meshes notice they may follow the wrong copy
+		int splits = 0;
+		GpuAllocation allocation;
+
+		SharedBuffer(size_t size, const void* data);
+		SharedBuffer(BufferHeap& heap, size_t size, size_t alignment, const void* data);
+		SharedBuffer(const SharedBuffer&) = delete;
+		SharedBuffer& operator=(const SharedBuffer&) = delete;
+		~SharedBuffer();
+
+		GLuint GetBuffer() const;
+		size_t GetOffset() const;
+		std::shared_ptr<SharedBuffer> Clone() const;
+		std::shared_ptr<SharedBuffer> Split();
+		void SetLabel(std::string label);
+
+		static void RecordShare(size_t bytes);
+		static void RecordSplit(size_t bytes);
+		static BufferShareStats GetStats();
+		static void ResetStats();
+	};
+
+	template <typename T>
+	class VArray
+	{
+	public:
+		int count = 0;
+		int elemSize = 0;
+		std::shared_ptr<SharedBuffer> storage;
+
+		VArray() {};
 		VArray(int elemCount, int elemSize, T* data)
 		{
-			glGenBuffers(1, &id);
-			glBindBuffer(GL_ARRAY_BUFFER, id);
-			glBufferData(GL_ARRAY_BUFFER, elemCount* elemSize * sizeof(T), data, GL_DYNAMIC_DRAW);
 			this->count = elemCount;
 			this->elemSize = elemSize;
-			this->hasArray = true;
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			this->storage = std::make_shared<SharedBuffer>(GetByteSize(), data);
+		}
+		// Sub-allocated from a heap; the slice is aligned to the stride so GetFirst is exact
+		VArray(BufferHeap& heap, int elemCount, int elemSize, T* data)
+		{
+			this->count = elemCount;
+			this->elemSize = elemSize;
+			this->storage = std::make_shared<SharedBuffer>(heap, GetByteSize(), GetStride(), data);
 		}
-		// Copy constructor
+		// Copy constructor, shares the buffer until one side calls Set
 		VArray(const VArray& other)
 		{
-			if (!other.hasArray)
-			{
-				this->id = 0;
-				this->count = 0;
-				this->elemSize = 0;
-				this->hasArray = false;
-				return;
-			}
-
-			glGenBuffers(1, &id);
-			this->count = other.count;
-			this->elemSize = other.elemSize;
-			this->hasArray = true;
-
-			glBindBuffer(GL_COPY_READ_BUFFER, other.id);
-			glBindBuffer(GL_COPY_WRITE_BUFFER, id);
-			glBufferData(GL_COPY_WRITE_BUFFER, count * elemSize * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
-			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * elemSize * sizeof(T));
-			glBindBuffer(GL_COPY_READ_BUFFER, 0);
-			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			ShareFrom(other);
 		}
 
 		// Copy assignment
@@ -159,45 +1129,17 @@ namespace SimView
 			if (this == &other)
 				return *this;
 
-			if (this->hasArray)
-			{
-				glDeleteBuffers(1, &id);
-			}
-
-			if (!other.hasArray)
-			{
-				this->id = 0;
-				this->count = 0;
-				this->elemSize = 0;
-				this->hasArray = false;
-				return *this;
-			}
-
-			glGenBuffers(1, &id);
-			this->count = other.count;
-			this->elemSize = other.elemSize;
-			this->hasArray = true;
-
-			glBindBuffer(GL_COPY_READ_BUFFER, other.id);
-			glBindBuffer(GL_COPY_WRITE_BUFFER, id);
-			glBufferData(GL_COPY_WRITE_BUFFER, count * elemSize * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
-			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * elemSize * sizeof(T));
-			glBindBuffer(GL_COPY_READ_BUFFER, 0);
-			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
-
+			Destroy();
+			ShareFrom(other);
 			return *this;
 		}
 
 		// Move constructor
 		VArray(VArray&& other) noexcept
 		{
-			this->id = other.id;
 			this->count = other.count;
 			this->elemSize = other.elemSize;
-			this->hasArray = other.hasArray;
-
-			other.hasArray = false;
-			other.id = 0;
+			this->storage = std::move(other.storage);
 		}
 
 		// Move assignment
@@ -205,60 +1147,318 @@ namespace SimView
 		{
 			if (this != &other)
 			{
-				if (this->hasArray)
-				{
-					glDeleteBuffers(1, &id);
-				}
-
-				this->id = other.id;
 				this->count = other.count;
 				this->elemSize = other.elemSize;
-				this->hasArray = other.hasArray;
-
-				other.hasArray = false;
-				other.id = 0;
+				this->storage = std::move(other.storage);
 			}
 			return *this;
 		}
 		~VArray()
 		{
-			if (hasArray)
+			Destroy();
+		}
+
+		// Explicit device copy
+		VArray Clone() const
+		{
+			VArray copy;
+			copy.count = count;
+			copy.elemSize = elemSize;
+			if (storage)
+				copy.storage = storage->Clone();
+			return copy;
+		}
+
+		size_t GetByteSize() const
+		{
+			return size_t(count) * elemSize * sizeof(T);
+		}
+		size_t GetStride() const
+		{
+			return size_t(elemSize) * sizeof(T);
+		}
+		GLuint GetBuffer() const
+		{
+			return storage ? storage->GetBuffer() : 0;
+		}
+		size_t GetOffset() const
+		{
+			return storage ? storage->GetOffset() : 0;
+		}
+		// Index of the first element within the shared buffer, for draws that bind the whole buffer once
+		int GetFirst() const
+		{
+			return int(GetOffset() / GetStride());
+		}
+		bool IsShared() const
+		{
+			return storage && storage.use_count() > 1;
+		}
+		void Set(int index, int elemCount, T* data)
+		{
+			if (IsShared())
+				storage = storage->Split();
+			glNamedBufferSubData(GetBuffer(), GetOffset() + index * GetStride(), elemCount * GetStride(), data);
+		}
+		void SetLabel(std::string label)
+		{
+			if (storage)
+				storage->SetLabel(label);
+		}
+		void Destroy()
+		{
+			storage.reset();
+		}
+
+	private:
+		void ShareFrom(const VArray& other)
+		{
+			this->count = other.count;
+			this->elemSize = other.elemSize;
+			this->storage = other.storage;
+			if (storage)
+				SharedBuffer::RecordShare(GetByteSize());
+		}
+	};
+
+	template <typename T>
+	class StreamVArray
+	{
+	public:
+		GLuint id = 0;
+		int count = 0;
+		int elemSize = 0;
+		int regionCount = 0;
+		int current = 0;
+		size_t regionBytes = 0;
+		unsigned char* mapped = nullptr;
+		std::vector<Fence> fences;
+		GpuAllocation allocation;
+
+		StreamVArray() {};
+		StreamVArray(int elemCount, int elemSize, int framesInFlight = 3)
+		{
+			this->count = elemCount;
+			this->elemSize = elemSize;
+			this->regionCount = framesInFlight;
+			this->regionBytes = (size_t(elemCount) * elemSize * sizeof(T) + BitmapPool::Alignment - 1) & ~(BitmapPool::Alignment - 1);
+			this->current = framesInFlight - 1;
+			fences.resize(framesInFlight);
+
+			// One region per frame in flight, the CPU writes one while the GPU reads the others
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glCreateBuffers(1, &id);
+			glNamedBufferStorage(id, regionBytes * regionCount, nullptr, flags);
+			mapped = (unsigned char*)glMapNamedBufferRange(id, 0, regionBytes * regionCount, flags);
+			if (mapped == nullptr)
 			{
+				// The destructor does not run for a throwing constructor
 				glDeleteBuffers(1, &id);
+				id = 0;
+				throw std::runtime_error("StreamVArray Error: Failed to map buffer\n");
 			}
+			allocation = GpuAllocation(GpuResourceType::VertexBuffer, regionBytes * regionCount);
 		}
+		StreamVArray(const StreamVArray&) = delete;
+		StreamVArray& operator=(const StreamVArray&) = delete;
 
-		void Set(int index, int elemCount, T* data)
+		// Move constructor
+		StreamVArray(StreamVArray&& other) noexcept
+		{
+			MoveFrom(other);
+		}
+
+		// Move assignment
+		StreamVArray& operator=(StreamVArray&& other) noexcept
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, id);
-			glBufferSubData(GL_ARRAY_BUFFER, index * elemSize * sizeof(T), elemCount * elemSize * sizeof(T), data);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			if (this != &other)
+			{
+				Destroy();
+				MoveFrom(other);
+			}
+			return *this;
+		}
+		~StreamVArray()
+		{
+			Destroy();
+		}
+
+		// Frame functions, data written between BeginFrame and EndFrame goes to the current region
+
+		T* BeginFrame()
+		{
+			current = (current + 1) % regionCount;
+			fences[current].Wait();
+			return GetData();
+		}
+		void EndFrame()
+		{
+			// Placed after the draws that read this region
+			fences[current].Set();
+		}
+		T* GetData() const
+		{
+			return (T*)(mapped + current * regionBytes);
+		}
+		size_t GetOffset() const
+		{
+			return current * regionBytes;
+		}
+		void Set(int index, int elemCount, const T* data)
+		{
+			std::memcpy(GetData() + size_t(index) * elemSize, data, size_t(elemCount) * elemSize * sizeof(T));
+		}
+		void SetLabel(std::string label)
+		{
+			glObjectLabel(GL_BUFFER, id, -1, label.c_str());
+			allocation.SetLabel(label);
 		}
 		void Destroy()
 		{
-			if (hasArray)
+			if (id != 0)
 			{
+				fences.clear();
+				glUnmapNamedBuffer(id);
 				glDeleteBuffers(1, &id);
 			}
-			hasArray = false;
+			id = 0;
+			mapped = nullptr;
+			allocation.Release();
+		}
+
+	private:
+		void MoveFrom(StreamVArray& other)
+		{
+			this->id = other.id;
+			this->count = other.count;
+			this->elemSize = other.elemSize;
+			this->regionCount = other.regionCount;
+			this->current = other.current;
+			this->regionBytes = other.regionBytes;
+			this->mapped = other.mapped;
+			this->fences = std::move(other.fences);
+			this->allocation = std::move(other.allocation);
+
+			other.id = 0;
+			other.mapped = nullptr;
 		}
 	};
 
+	// Stored as the narrowest of GL_UNSIGNED_BYTE/SHORT/INT that holds the largest index
 	class IndexArray
 	{
 	public:
-		GLuint id;
-		int count;
-		bool hasArray;
+		GLuint id = 0;
+		int count = 0;
+		GLenum type = GL_UNSIGNED_INT;
+		HeapRef heap;
+		int slice = -1;
+		GpuAllocation allocation;
 
-		IndexArray();
-		IndexArray(int elemCount, int* data);
-		IndexArray(IndexArray& other);
-		IndexArray& operator=(IndexArray&& other);
+		IndexArray() {};
+		IndexArray(int elemCount, int* data, int maxIndex = -1);
+		IndexArray(BufferHeap& heap, int elemCount, int* data, int maxIndex = -1);
+		IndexArray(const IndexArray&) = delete;
+		IndexArray& operator=(const IndexArray&) = delete;
+		IndexArray(IndexArray&& other) noexcept;
+		IndexArray& operator=(IndexArray&& other) noexcept;
 		~IndexArray();
 
+		GLuint GetBuffer() const;
+		size_t GetOffset() const;
+		int GetIndexSize() const;
+		size_t GetByteSize() const;
 		void Set(int index, int elemCount, int* data);
+		void SetLabel(std::string label);
 		void Destroy();
+
+		static GLenum GetIndexType(u32 maxIndex);
+		static int GetIndexSize(GLenum type);
+		static u32 FindMaxIndex(const int* data, size_t count);
+		static void Narrow(const int* src, void* dst, size_t count, GLenum type);
+
+	private:
+		void Create(BufferHeap* heap, int elemCount, const int* data, GLenum type);
+	};
+
+	// Owns a VAO whose vertex format is set up once; drawing only binds it.
+	// A mesh made with ShareFormat has no VAO of its own and swaps its buffers into the owner's.
+	// Arrays are tracked by their storage and heap slices by handle, so buffers and offsets are
+	// resolved again on Bind and follow BufferHeap::Defragment.
+	// VArray::Set on an array that still shares its buffer with a copy moves one side to a new buffer;
+	// Bind throws after that until SetArray is called again, since the mesh can't tell which copy it meant
+	class Mesh
+	{
+	public:
+		GLuint id = 0;
+		GLuint formatId = 0;
+		mutable std::vector<GLuint> buffers;
+		mutable std::vector<GLintptr> offsets;
+		std::vector<GLsizei> strides;
+		mutable GLuint indexBuffer = 0;
+		mutable size_t indexOffset = 0;
+		GLenum indexType = GL_UNSIGNED_INT;
+		int indexCount = 0;
+		int vertexCount = 0;
+
+		Mesh();
+		Mesh(const Mesh&) = delete;
+		Mesh& operator=(const Mesh&) = delete;
+		Mesh(Mesh&& other) noexcept;
+		Mesh& operator=(Mesh&& other) noexcept;
+		~Mesh();
+
+		static Mesh ShareFormat(const Mesh& format);
+
+		// Format functions, only valid on a mesh that owns its VAO
+
+		int AddBinding(const VertexLayout& layout, const std::vector<GLint>& locs, GLuint divisor = 0);
+		int AddArray(VArray<float>& array, GLint loc, GLuint divisor = 0);
+		int AddArray(VArray<int>& array, GLint loc, GLuint divisor = 0);
+		template <typename T>
+		int AddArray(VArray<T>& array, const std::vector<GLint>& locs, const VertexLayout& layout = VertexLayout::Of<T>(), GLuint divisor = 0)
+		{
+			int binding = AddBinding(layout, locs, divisor);
+			SetArray(binding, array);
+			if (divisor == 0)
+				vertexCount = array.count;
+			return binding;
+		}
+
+		// Buffer functions
+
+		template <typename T>
+		void SetArray(int binding, VArray<T>& array)
+		{
+			SetStorage(binding, array.storage);
+		}
+		void SetStorage(int binding, const std::shared_ptr<SharedBuffer>& storage);
+		void SetBuffer(int binding, GLuint buffer, size_t offset);
+		void SetIndexArray(IndexArray& array);
+		void Bind() const;
+		void SetLabel(std::string label);
+		void Destroy();
+
+		static void SetFormat(GLuint vao, GLuint binding, const VertexLayout& layout, const std::vector<GLint>& locs);
+		static void SetDefault(GLuint vao);
+		static GLuint GetDefault();
+		static void BindDefault();
+
+	private:
+		// Weak, so the mesh does not count as a sharer and force VArray::Set to copy
+		struct Source
+		{
+			std::weak_ptr<SharedBuffer> storage;
+			int splits = 0;
+			bool tracked = false;
+		};
+		std::vector<Source> sources;
+		HeapRef indexHeap;
+		int indexSlice = -1;
+
+		Mesh(GLuint formatId, size_t bindingCount);
+		bool Resolve() const;
+		void Forget() const;
 	};
 
 	class ShaderProgram
@@ -269,6 +1469,9 @@ namespace SimView
 		bool instanced;
 		int instanceCount;
 		bool hasIndexArray;
+		size_t indexOffset = 0;
+		GLenum indexType = GL_UNSIGNED_INT;
+		GLint baseVertex = 0;
 
 		ShaderProgram();
 		ShaderProgram(const char* vertexSource, const char* fragmentSource, bool instanced, std::vector<std::string> uniforms, std::vector<std::string> attribs);
@@ -282,13 +1485,33 @@ namespace SimView
 
 		void BindArray(VArray<float>& array, GLint loc);
 		void BindArray(VArray<int>& array, GLint loc);
+		void BindArray(StreamVArray<float>& array, GLint loc);
+		void BindArray(StreamVArray<int>& array, GLint loc);
+		void BindHeapArray(VArray<float>& array, GLint loc);
+		void BindHeapArray(VArray<int>& array, GLint loc);
+		void BindLayout(GLuint buffer, size_t offset, const VertexLayout& layout, const std::vector<GLint>& locs);
+		// Only binds the mesh's VAO; the Render functions other than RenderMesh draw from the default one
+		void BindMesh(const Mesh& mesh);
+		template <typename T>
+		void BindArray(VArray<T>& array, const std::vector<GLint>& locs, const VertexLayout& layout = VertexLayout::Of<T>())
+		{
+			BindLayout(array.GetBuffer(), array.GetOffset(), layout, locs);
+		}
+		template <typename T>
+		void BindArray(StreamVArray<T>& array, const std::vector<GLint>& locs, const VertexLayout& layout = VertexLayout::Of<T>())
+		{
+			BindLayout(array.id, array.GetOffset(), layout, locs);
+		}
 		void BindTexture(const Texture& texture);
 		void BindTextureArray(const TextureArray& textureArray);
+		void BindTextures(const TextureBindings& bindings);
+		void BindTextureUnit(int unit, GLint loc);
 		void BindIndexArray(IndexArray& array);
 		void UnbindIndexArray();
 
 		void SetInstanceCount(int count);
 		void SetArrayDivisor(int divisor, GLint loc);
+		void SetBaseVertex(GLint base);
 
 		void BindColor(Color color, GLint loc);
 		void BindMat2x2(glm::mat2x2 matrix, GLint loc);
@@ -307,14 +1530,7 @@ namespace SimView
 		void RenderLines(int count, int index = 0);
 		void RenderPolyline(int count, int index = 0);
 		void RenderPoints(int count, int index = 0);
-	};
-
-	enum class BlendMode
-	{
-		Default,
-		Alpha,
-		PreMultAlpha,
-		Add,
+		void RenderMesh(const Mesh& mesh, GLenum drawCall = GL_TRIANGLES);
 	};
 
 	class Window
@@ -0,0 +1,264 @@
+#include "SimView.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace SimView
+{
+	static inline float Edge(glm::vec2 a, glm::vec2 b, glm::vec2 p)
+	{
+		return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+	}
+
+	// Top-left fill rule for screen space with y pointing down, so shared edges are drawn exactly once
+	static inline bool IsTopLeft(glm::vec2 a, glm::vec2 b)
+	{
+		return (a.y == b.y && b.x > a.x) || b.y < a.y;
+	}
+
+	static inline unsigned char Modulate(int a, int b)
+	{
+		int t = a * b + 128;
+		return (unsigned char)((t + (t >> 8)) >> 8);
+	}
+
+	// Nearest filtering with a transparent border, matching Texture's GL_CLAMP_TO_BORDER default
+	static inline Color Sample(const Bitmap& texture, glm::vec2 uv)
+	{
+		int x = (int)std::floor(uv.x * texture.width);
+		int y = (int)std::floor(uv.y * texture.height);
+		if (x < 0 || y < 0 || x >= texture.width || y >= texture.height)
+			return { 0,0,0,0 };
+		return texture.data[texture.GetIndex(x, y)];
+	}
+
+	SoftRasterizer::SoftRasterizer(Bitmap& target, ThreadPool& pool)
+	{
+		if (target.format != PixelFormat::RGBA8)
+			throw std::runtime_error("SoftRasterizer Error: Render target must be an RGBA8 bitmap\n");
+		this->target = &target;
+		this->pool = &pool;
+	}
+
+	void SoftRasterizer::SetBlendMode(BlendMode mode)
+	{
+		this->mode = mode;
+	}
+
+	void SoftRasterizer::SetColor(Color color)
+	{
+		this->color = color;
+	}
+
+	void SoftRasterizer::SetTexture(const Bitmap* texture)
+	{
+		if (texture != nullptr && texture->format != PixelFormat::RGBA8)
+			throw std::runtime_error("SoftRasterizer Error: Texture must be an RGBA8 bitmap\n");
+		this->texture = texture;
+	}
+
+	void SoftRasterizer::SetLineWidth(float width)
+	{
+		lineWidth = width;
+	}
+
+	void SoftRasterizer::SetPointSize(float size)
+	{
+		pointSize = size;
+	}
+
+	glm::vec2 SoftRasterizer::ToScreen(glm::vec2 ndc) const
+	{
+		return { (ndc.x + 1) * 0.5f * target->width, (1 - ndc.y) * 0.5f * target->height };
+	}
+
+	void SoftRasterizer::AddTriangle(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 uvA, glm::vec2 uvB, glm::vec2 uvC)
+	{
+		float area = Edge(a, b, c);
+		if (area == 0)
+			return;
+		if (area < 0)
+		{
+			std::swap(b, c);
+			std::swap(uvB, uvC);
+		}
+		triangles.push_back({ { a, b, c }, { uvA, uvB, uvC }, color, texture, mode });
+	}
+
+	void SoftRasterizer::FillScreen(Color color)
+	{
+		Flush();
+		std::fill_n(target->data, target->width * target->height, color);
+		target->MarkAllDirty();
+	}
+
+	void SoftRasterizer::RenderTri(const glm::vec2* positions, const glm::vec2* uvs)
+	{
+		RenderTris(1, positions, uvs);
+	}
+
+	void SoftRasterizer::RenderTris(int count, const glm::vec2* positions, const glm::vec2* uvs)
+	{
+		glm::vec2 noUv = { 0,0 };
+		for (int i = 0; i < count; i++)
+		{
+			const glm::vec2* p = positions + i * 3;
+			const glm::vec2* uv = uvs ? uvs + i * 3 : nullptr;
+			AddTriangle(ToScreen(p[0]), ToScreen(p[1]), ToScreen(p[2]), uv ? uv[0] : noUv, uv ? uv[1] : noUv, uv ? uv[2] : noUv);
+		}
+	}
+
+	void SoftRasterizer::RenderQuad(const glm::vec2* positions, const glm::vec2* uvs)
+	{
+		// Same fan order as ShaderProgram::RenderQuad
+		glm::vec2 noUv[4] = {};
+		if (uvs == nullptr)
+			uvs = noUv;
+		AddTriangle(ToScreen(positions[0]), ToScreen(positions[1]), ToScreen(positions[2]), uvs[0], uvs[1], uvs[2]);
+		AddTriangle(ToScreen(positions[0]), ToScreen(positions[2]), ToScreen(positions[3]), uvs[0], uvs[2], uvs[3]);
+	}
+
+	void SoftRasterizer::RenderLine(const glm::vec2* positions)
+	{
+		RenderLines(1, positions);
+	}
+
+	void SoftRasterizer::RenderLines(int count, const glm::vec2* positions)
+	{
+		// Line strip of count segments like ShaderProgram::RenderLines, each segment expanded to a quad of lineWidth
+		const Bitmap* savedTexture = texture;
+		texture = nullptr;
+		glm::vec2 uv = { 0,0 };
+		for (int i = 0; i < count; i++)
+		{
+			glm::vec2 a = ToScreen(positions[i]);
+			glm::vec2 b = ToScreen(positions[i + 1]);
+			float length = glm::length(b - a);
+			if (length == 0)
+				continue;
+			glm::vec2 dir = (b - a) * (1.f / length);
+			glm::vec2 normal = glm::vec2(-dir.y, dir.x) * (lineWidth * 0.5f);
+			AddTriangle(a + normal, b + normal, b - normal, uv, uv, uv);
+			AddTriangle(a + normal, b - normal, a - normal, uv, uv, uv);
+		}
+		texture = savedTexture;
+	}
+
+	void SoftRasterizer::RenderPoints(int count, const glm::vec2* positions)
+	{
+		// Square points of pointSize pixels, like GL_POINTS without point sprites
+		const Bitmap* savedTexture = texture;
+		texture = nullptr;
+		glm::vec2 uv = { 0,0 };
+		float half = pointSize * 0.5f;
+		for (int i = 0; i < count; i++)
+		{
+			glm::vec2 c = ToScreen(positions[i]);
+			glm::vec2 a = { c.x - half, c.y - half };
+			glm::vec2 b = { c.x + half, c.y - half };
+			glm::vec2 d = { c.x + half, c.y + half };
+			glm::vec2 e = { c.x - half, c.y + half };
+			AddTriangle(a, b, d, uv, uv, uv);
+			AddTriangle(a, d, e, uv, uv, uv);
+		}
+		texture = savedTexture;
+	}
+
+	void SoftRasterizer::Flush()
+	{
+		if (triangles.empty())
+			return;
+
+		int tilesX = (target->width + TileSize - 1) / TileSize;
+		int tilesY = (target->height + TileSize - 1) / TileSize;
+
+		// Bin triangles by bounding box, bins keep submission order so blending stays ordered within each tile
+		std::vector<std::vector<int>> bins(size_t(tilesX) * tilesY);
+		for (int i = 0; i < (int)triangles.size(); i++)
+		{
+			const Triangle& tri = triangles[i];
+			float minX = std::min({ tri.p[0].x, tri.p[1].x, tri.p[2].x });
+			float maxX = std::max({ tri.p[0].x, tri.p[1].x, tri.p[2].x });
+			float minY = std::min({ tri.p[0].y, tri.p[1].y, tri.p[2].y });
+			float maxY = std::max({ tri.p[0].y, tri.p[1].y, tri.p[2].y });
+			int tx0 = std::max((int)std::floor(minX) / TileSize, 0);
+			int ty0 = std::max((int)std::floor(minY) / TileSize, 0);
+			int tx1 = std::min((int)std::floor(maxX) / TileSize, tilesX - 1);
+			int ty1 = std::min((int)std::floor(maxY) / TileSize, tilesY - 1);
+			if (maxX < 0 || maxY < 0)
+				continue;
+			for (int ty = ty0; ty <= ty1; ty++)
+				for (int tx = tx0; tx <= tx1; tx++)
+					bins[size_t(ty) * tilesX + tx].push_back(i);
+		}
+
+		pool->ParallelFor(tilesX * tilesY, [&](int tile)
+		{
+			if (!bins[tile].empty())
+				RasterizeTile(bins[tile], tile % tilesX, tile / tilesX);
+		});
+		for (int tile = 0; tile < tilesX * tilesY; tile++)
+			if (!bins[tile].empty())
+				target->MarkDirty(tile % tilesX * TileSize, tile / tilesX * TileSize, TileSize, TileSize);
+		triangles.clear();
+	}
+
+	void SoftRasterizer::RasterizeTile(const std::vector<int>& bin, int tileX, int tileY) const
+	{
+		int tileX0 = tileX * TileSize;
+		int tileY0 = tileY * TileSize;
+		int tileX1 = std::min(tileX0 + TileSize, target->width);
+		int tileY1 = std::min(tileY0 + TileSize, target->height);
+
+		for (int index : bin)
+		{
+			const Triangle& tri = triangles[index];
+			glm::vec2 v0 = tri.p[0], v1 = tri.p[1], v2 = tri.p[2];
+
+			int x0 = std::max((int)std::floor(std::min({ v0.x, v1.x, v2.x })), tileX0);
+			int y0 = std::max((int)std::floor(std::min({ v0.y, v1.y, v2.y })), tileY0);
+			int x1 = std::min((int)std::ceil(std::max({ v0.x, v1.x, v2.x })), tileX1);
+			int y1 = std::min((int)std::ceil(std::max({ v0.y, v1.y, v2.y })), tileY1);
+			if (x0 >= x1 || y0 >= y1)
+				continue;
+
+			float invArea = 1.f / Edge(v0, v1, v2);
+			bool topLeft0 = IsTopLeft(v1, v2);
+			bool topLeft1 = IsTopLeft(v2, v0);
+			bool topLeft2 = IsTopLeft(v0, v1);
+
+			// Edge functions step linearly across the tile
+			glm::vec2 start = { x0 + 0.5f, y0 + 0.5f };
+			float row0 = Edge(v1, v2, start), row1 = Edge(v2, v0, start), row2 = Edge(v0, v1, start);
+			float stepX0 = v1.y - v2.y, stepX1 = v2.y - v0.y, stepX2 = v0.y - v1.y;
+			float stepY0 = v2.x - v1.x, stepY1 = v0.x - v2.x, stepY2 = v1.x - v0.x;
+
+			for (int y = y0; y < y1; y++)
+			{
+				float w0 = row0, w1 = row1, w2 = row2;
+				Color* row = target->data + target->GetIndex(0, y);
+				for (int x = x0; x < x1; x++)
+				{
+					bool inside = (w0 > 0 || (w0 == 0 && topLeft0)) && (w1 > 0 || (w1 == 0 && topLeft1)) && (w2 > 0 || (w2 == 0 && topLeft2));
+					if (inside)
+					{
+						Color src = tri.color;
+						if (tri.texture != nullptr)
+						{
+							float l0 = w0 * invArea, l1 = w1 * invArea, l2 = w2 * invArea;
+							glm::vec2 uv = tri.uv[0] * l0 + tri.uv[1] * l1 + tri.uv[2] * l2;
+							Color texel = Sample(*tri.texture, uv);
+							src = { Modulate(texel.r, src.r), Modulate(texel.g, src.g), Modulate(texel.b, src.b), Modulate(texel.a, src.a) };
+						}
+						row[x] = Color::Blend(src, row[x], tri.mode);
+					}
+					w0 += stepX0;
+					w1 += stepX1;
+					w2 += stepX2;
+				}
+				row0 += stepY0;
+				row1 += stepY1;
+				row2 += stepY2;
+			}
+		}
+	}
+}
\ No newline at end of file
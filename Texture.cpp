@@ -2,47 +2,171 @@
 
 namespace SimView
 {
-    Texture::Texture()
+    Texture::Texture(int width, int height, Color* data) : Texture(width, height, PixelFormat::RGBA8, data)
     {
-        id = -1;
     }
-    Texture::Texture(int width, int height, Color* data)
+    // Only level 0 unless mipLevels asks for more, GenMipmaps grows the storage when it needs the chain
+    Texture::Texture(int width, int height, PixelFormat format, const void* data, int mipLevels) : Texture(width, height, mipLevels, PixelFormatInfo::Get(format).internalFormat)
     {
-        glGenTextures(1, &id);
-        glBindTexture(GL_TEXTURE_2D, id);
+        const PixelFormatInfo& info = PixelFormatInfo::Get(format);
+        glTextureParameteri(id, GL_TEXTURE_MAX_LEVEL, 0);
+
+        if (data != nullptr)
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(width));
+            glTextureSubImage2D(id, 0, 0, 0, width, height, info.format, info.type, data);
+        }
+    }
+    Texture::Texture(int width, int height, int mipLevels, GLenum internalFormat)
+    {
+        this->width = width;
+        this->height = height;
+        this->levels = mipLevels;
+        this->internalFormat = internalFormat;
+        allocation = GpuAllocation(GpuResourceType::Texture, GpuMemory::GetTextureBytes(internalFormat, width, height, mipLevels));
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &id);
+        glTextureStorage2D(id, mipLevels, internalFormat, width, height);
+
+        glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    // Move constructor
+    Texture::Texture(Texture&& other) noexcept
+    {
+        this->id = other.id;
+        this->width = other.width;
+        this->height = other.height;
+        this->levels = other.levels;
+        this->internalFormat = other.internalFormat;
+        this->allocation = std::move(other.allocation);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        other.id = 0;
+    }
+    // Move assignment
+    Texture& Texture::operator=(Texture&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Destroy();
 
-        if(data != nullptr)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            this->id = other.id;
+            this->width = other.width;
+            this->height = other.height;
+            this->levels = other.levels;
+            this->internalFormat = other.internalFormat;
+            this->allocation = std::move(other.allocation);
 
-        glBindTexture(GL_TEXTURE_2D, 0);
+            other.id = 0;
+        }
+        return *this;
+    }
+    Texture::~Texture()
+    {
+        Destroy();
+    }
+    void Texture::SetLabel(std::string label)
+    {
+        glObjectLabel(GL_TEXTURE, id, -1, label.c_str());
+        allocation.SetLabel(label);
+    }
+    void Texture::Destroy()
+    {
+        if (id != 0)
+        {
+            glDeleteTextures(1, &id);
+            TextureBindings::Forget(id);
+        }
+        id = 0;
+        allocation.Release();
+    }
+    void Texture::SetLevel(int level, const Bitmap& image)
+    {
+        const PixelFormatInfo& info = PixelFormatInfo::Get(image.format);
+        if (info.internalFormat != internalFormat)
+            throw std::runtime_error("Texture Error: Level format does not match the texture\n");
+        glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(image.width));
+        glTextureSubImage2D(id, level, 0, 0, image.width, image.height, info.format, info.type, image.data);
+    }
+    void Texture::Update(Bitmap& image)
+    {
+        const PixelFormatInfo& info = PixelFormatInfo::Get(image.format);
+        if (info.internalFormat != internalFormat)
+            throw std::runtime_error("Texture Error: Bitmap format does not match the texture\n");
+        std::vector<Rect> rects = image.TakeDirtyRects();
+        if (rects.empty())
+            return;
+
+        // Sub-rectangles are read in place from the full-width bitmap rows
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, image.width);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(image.width));
+        for (const Rect& rect : rects)
+        {
+            const unsigned char* pixels = (const unsigned char*)image.data + (size_t(rect.y) * image.width + rect.x) * info.bytes;
+            glTextureSubImage2D(id, 0, rect.x, rect.y, rect.width, rect.height, info.format, info.type, pixels);
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     }
     void Texture::GenMipmaps(int maxLod, float bias)
     {
-        glBindTexture(GL_TEXTURE_2D, id);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, bias);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LOD, maxLod);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        // Storage is immutable, so a single level texture is moved into a new one with room for the chain
+        int fullLevels = Bitmap::MipLevelCount(width, height);
+        if (levels == 1 && fullLevels > 1)
+        {
+            Texture grown(width, height, fullLevels, internalFormat);
+            glCopyImageSubData(id, GL_TEXTURE_2D, 0, 0, 0, 0, grown.id, GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1);
+            if (!allocation.label.empty())
+                grown.SetLabel(allocation.label);
+            *this = std::move(grown);
+        }
+
+        glTextureParameterf(id, GL_TEXTURE_LOD_BIAS, bias);
+        glTextureParameteri(id, GL_TEXTURE_MAX_LOD, maxLod);
+        glTextureParameteri(id, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glGenerateTextureMipmap(id);
     }
     Texture Texture::FromBitmap(Bitmap& image)
     {
-        return Texture(image.width, image.height, image.data);
+        return Texture(image.width, image.height, image.format, image.data);
+    }
+    Texture Texture::FromMipChain(const Bitmap& image, const std::vector<Bitmap>& mips)
+    {
+        Texture texture(image.width, image.height, (int)mips.size() + 1, PixelFormatInfo::Get(image.format).internalFormat);
+        texture.SetLevel(0, image);
+        for (int level = 0; level < (int)mips.size(); level++)
+            texture.SetLevel(level + 1, mips[level]);
+        return texture;
+    }
+    Texture Texture::FromCompressed(const CompressedImage& image)
+    {
+        GLenum blockFormat = image.GetInternalFormat();
+        Texture texture(image.width, image.height, (int)image.levels.size(), blockFormat);
+        for (int level = 0; level < (int)image.levels.size(); level++)
+        {
+            int width = std::max(image.width >> level, 1);
+            int height = std::max(image.height >> level, 1);
+            glCompressedTextureSubImage2D(texture.id, level, 0, 0, width, height, blockFormat, (GLsizei)image.levels[level].size(), image.levels[level].data());
+        }
+        return texture;
     }
     Texture Texture::FromTextureArray(TextureArray& texArray, int layer)
     {
         GLuint id;
         glGenTextures(1, &id);
-        glTextureView(id, GL_TEXTURE_2D, texArray.id, GL_RGBA8, 0, 1, layer, 1);
-        glBindTexture(GL_TEXTURE_2D, id);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        return Texture(id);
+        glTextureView(id, GL_TEXTURE_2D, texArray.id, texArray.internalFormat, 0, 1, layer, 1);
+        glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        // Views share the array's storage so they add nothing to the memory totals
+        Texture texture(id);
+        texture.width = texArray.width;
+        texture.height = texArray.height;
+        texture.levels = 1;
+        texture.internalFormat = texArray.internalFormat;
+        return texture;
     }
 }
\ No newline at end of file
@@ -2,32 +2,132 @@
 
 namespace SimView
 {
-	TextureArray::TextureArray()
+	TextureArray::TextureArray(int width, int height, int layers, int mipLevel, PixelFormat format) : TextureArray(width, height, layers, mipLevel, PixelFormatInfo::Get(format).internalFormat)
 	{
-		id = -1;
+		this->format = format;
 	}
-	TextureArray::TextureArray(int width, int height, int layers, int mipLevel)
+	TextureArray::TextureArray(int width, int height, int layers, int mipLevel, GLenum internalFormat)
 	{
-		glGenTextures(1, &id);
-		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
-		glTexStorage3D(GL_TEXTURE_2D_ARRAY, mipLevel, GL_RGBA8, width, height, layers);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		this->width = width;
+		this->height = height;
+		this->layers = layers;
+		this->levels = mipLevel;
+		this->internalFormat = internalFormat;
+		allocation = GpuAllocation(GpuResourceType::TextureArray, GpuMemory::GetTextureBytes(internalFormat, width, height, mipLevel, layers));
+
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &id);
+		glTextureStorage3D(id, mipLevel, internalFormat, width, height, layers);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+		glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	// Move constructor
+	TextureArray::TextureArray(TextureArray&& other) noexcept
+	{
+		this->id = other.id;
+		this->width = other.width;
+		this->height = other.height;
+		this->layers = other.layers;
+		this->levels = other.levels;
+		this->format = other.format;
+		this->internalFormat = other.internalFormat;
+		this->allocation = std::move(other.allocation);
+
+		other.id = 0;
+	}
+	// Move assignment
+	TextureArray& TextureArray::operator=(TextureArray&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Destroy();
+
+			this->id = other.id;
+			this->width = other.width;
+			this->height = other.height;
+			this->layers = other.layers;
+			this->levels = other.levels;
+			this->format = other.format;
+			this->internalFormat = other.internalFormat;
+			this->allocation = std::move(other.allocation);
+
+			other.id = 0;
+		}
+		return *this;
+	}
+	TextureArray::~TextureArray()
+	{
+		Destroy();
+	}
+	void TextureArray::SetLabel(std::string label)
+	{
+		glObjectLabel(GL_TEXTURE, id, -1, label.c_str());
+		allocation.SetLabel(label);
+	}
+	void TextureArray::Destroy()
+	{
+		if (id != 0)
+		{
+			glDeleteTextures(1, &id);
+			TextureBindings::Forget(id);
+		}
+		id = 0;
+		allocation.Release();
 	}
 	void TextureArray::LayerFromBitmap(Bitmap& image, int layer)
 	{
-		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
-		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, image.width, image.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, image.data);
-		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		const PixelFormatInfo& info = PixelFormatInfo::Get(image.format);
+		if (info.internalFormat != internalFormat)
+			throw std::runtime_error("TextureArray Error: Layer format does not match the array\n");
+		glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(image.width));
+		glTextureSubImage3D(id, 0, 0, 0, layer, image.width, image.height, 1, info.format, info.type, image.data);
+	}
+	void TextureArray::SetLayerLevel(int layer, int level, const Bitmap& image)
+	{
+		const PixelFormatInfo& info = PixelFormatInfo::Get(image.format);
+		if (info.internalFormat != internalFormat)
+			throw std::runtime_error("TextureArray Error: Level format does not match the array\n");
+		glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(image.width));
+		glTextureSubImage3D(id, level, 0, 0, layer, image.width, image.height, 1, info.format, info.type, image.data);
+	}
+	void TextureArray::LayerFromMipChain(const Bitmap& image, const std::vector<Bitmap>& mips, int layer)
+	{
+		SetLayerLevel(layer, 0, image);
+		for (int level = 0; level < (int)mips.size(); level++)
+			SetLayerLevel(layer, level + 1, mips[level]);
+	}
+	void TextureArray::UpdateLayer(Bitmap& image, int layer)
+	{
+		const PixelFormatInfo& info = PixelFormatInfo::Get(image.format);
+		if (info.internalFormat != internalFormat)
+			throw std::runtime_error("TextureArray Error: Layer format does not match the array\n");
+		std::vector<Rect> rects = image.TakeDirtyRects();
+		if (rects.empty())
+			return;
+
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, image.width);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(image.width));
+		for (const Rect& rect : rects)
+		{
+			const unsigned char* pixels = (const unsigned char*)image.data + (size_t(rect.y) * image.width + rect.x) * info.bytes;
+			glTextureSubImage3D(id, 0, rect.x, rect.y, layer, rect.width, rect.height, 1, info.format, info.type, pixels);
+		}
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+	void TextureArray::LayerFromCompressed(const CompressedImage& image, int layer)
+	{
+		GLenum blockFormat = image.GetInternalFormat();
+		for (int level = 0; level < (int)image.levels.size(); level++)
+		{
+			int width = std::max(image.width >> level, 1);
+			int height = std::max(image.height >> level, 1);
+			glCompressedTextureSubImage3D(id, level, 0, 0, layer, width, height, 1, blockFormat, (GLsizei)image.levels[level].size(), image.levels[level].data());
+		}
 	}
 	void TextureArray::GenMipmaps(float bias)
 	{
-		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
-		glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_LOD_BIAS, bias);
-		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
-		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glTextureParameterf(id, GL_TEXTURE_LOD_BIAS, bias);
+		glGenerateTextureMipmap(id);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "SimView.hpp"
+#include <algorithm>
+#include <climits>
+
+namespace SimView
+{
+	TextureAtlas::TextureAtlas(int width, int height, int padding)
+	{
+		this->width = width;
+		this->height = height;
+		this->padding = padding;
+		AddPage();
+	}
+
+	void TextureAtlas::AddPage()
+	{
+		pages.push_back(Bitmap::GetColorImage(width, height, { 0, 0, 0, 0 }));
+		pages.back().ClearDirty();
+		skylines.push_back({ { 0, 0, width } });
+		usedArea.push_back(0);
+	}
+
+	// Bottom-left skyline fit, ties go to the narrower segment to keep the skyline flat
+	bool TextureAtlas::FindPosition(const std::vector<SkylineNode>& skyline, int width, int height, int& bestX, int& bestY, int& bestIndex) const
+	{
+		int bestBottom = INT_MAX;
+		int bestWidth = INT_MAX;
+		bestIndex = -1;
+
+		for (int i = 0; i < (int)skyline.size(); i++)
+		{
+			int x = skyline[i].x;
+			if (x + width > this->width)
+				break;
+
+			int y = 0;
+			int remaining = width;
+			for (int j = i; remaining > 0; j++)
+			{
+				y = std::max(y, skyline[j].y);
+				remaining -= skyline[j].width;
+			}
+			if (y + height > this->height)
+				continue;
+
+			if (y + height < bestBottom || (y + height == bestBottom && skyline[i].width < bestWidth))
+			{
+				bestBottom = y + height;
+				bestWidth = skyline[i].width;
+				bestIndex = i;
+				bestX = x;
+				bestY = y;
+			}
+		}
+		return bestIndex != -1;
+	}
+
+	void TextureAtlas::AddLevel(std::vector<SkylineNode>& skyline, int index, int x, int y, int width, int height)
+	{
+		skyline.insert(skyline.begin() + index, { x, y + height, width });
+
+		// Trim or remove the segments now covered by the new one
+		for (int i = index + 1; i < (int)skyline.size(); i++)
+		{
+			int end = skyline[i - 1].x + skyline[i - 1].width;
+			if (skyline[i].x >= end)
+				break;
+
+			int shrink = end - skyline[i].x;
+			skyline[i].x += shrink;
+			skyline[i].width -= shrink;
+			if (skyline[i].width > 0)
+				break;
+			skyline.erase(skyline.begin() + i);
+			i--;
+		}
+
+		// Merge neighbours at the same height
+		for (int i = 0; i + 1 < (int)skyline.size(); i++)
+		{
+			if (skyline[i].y == skyline[i + 1].y)
+			{
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+				i--;
+			}
+		}
+	}
+
+	// Repeats the border pixels into the padding so filtering and lower mips don't bleed in neighbours
+	void TextureAtlas::ExtrudeGutter(Bitmap& page, int x, int y, int width, int height)
+	{
+		int x0 = std::max(x - padding, 0);
+		int x1 = std::min(x + width + padding, page.width);
+		int y0 = std::max(y - padding, 0);
+		int y1 = std::min(y + height + padding, page.height);
+
+		for (int row = y; row < y + height; row++)
+		{
+			Color* line = page.data + size_t(row) * page.width;
+			std::fill(line + x0, line + x, line[x]);
+			std::fill(line + x + width, line + x1, line[x + width - 1]);
+		}
+		for (int row = y0; row < y; row++)
+			std::copy(page.data + size_t(y) * page.width + x0, page.data + size_t(y) * page.width + x1, page.data + size_t(row) * page.width + x0);
+		for (int row = y + height; row < y1; row++)
+			std::copy(page.data + size_t(y + height - 1) * page.width + x0, page.data + size_t(y + height - 1) * page.width + x1, page.data + size_t(row) * page.width + x0);
+
+		page.MarkDirty(x0, y0, x1 - x0, y1 - y0);
+	}
+
+	int TextureAtlas::Add(const Bitmap& image)
+	{
+		int paddedWidth = image.width + padding * 2;
+		int paddedHeight = image.height + padding * 2;
+		if (paddedWidth > width || paddedHeight > height)
+			throw std::runtime_error("TextureAtlas Error: Image is larger than an atlas page\n");
+
+		// Existing pages are tried first so insertion never repacks what is already placed
+		int page = 0;
+		int x = 0, y = 0, index = -1;
+		while (!FindPosition(skylines[page], paddedWidth, paddedHeight, x, y, index))
+		{
+			page++;
+			if (page == (int)pages.size())
+				AddPage();
+		}
+		AddLevel(skylines[page], index, x, y, paddedWidth, paddedHeight);
+		usedArea[page] += size_t(paddedWidth) * paddedHeight;
+
+		x += padding;
+		y += padding;
+		pages[page].DrawBitmap(x, y, image.GetView());
+		if (padding > 0)
+			ExtrudeGutter(pages[page], x, y, image.width, image.height);
+
+		AtlasRegion region;
+		region.page = page;
+		region.x = x;
+		region.y = y;
+		region.width = image.width;
+		region.height = image.height;
+		region.uvMin = glm::vec2(float(x) / width, float(y) / height);
+		region.uvMax = glm::vec2(float(x + image.width) / width, float(y + image.height) / height);
+		regions.push_back(region);
+		return (int)regions.size() - 1;
+	}
+
+	const AtlasRegion& TextureAtlas::GetRegion(int index) const
+	{
+		return regions[index];
+	}
+
+	int TextureAtlas::GetPageCount() const
+	{
+		return (int)pages.size();
+	}
+
+	float TextureAtlas::GetOccupancy() const
+	{
+		size_t used = 0;
+		for (size_t area : usedArea)
+			used += area;
+		return float(used) / (float(width) * height * pages.size());
+	}
+
+	Texture TextureAtlas::BuildTexture(int page)
+	{
+		pages[page].ClearDirty();
+		return Texture::FromBitmap(pages[page]);
+	}
+
+	TextureArray TextureAtlas::BuildTextureArray(int layers, int mipLevels)
+	{
+		if (layers < (int)pages.size())
+			throw std::runtime_error("TextureAtlas Error: Texture array has fewer layers than the atlas has pages\n");
+
+		TextureArray texArray(width, height, layers, mipLevels);
+		for (int page = 0; page < (int)pages.size(); page++)
+		{
+			texArray.LayerFromBitmap(pages[page], page);
+			pages[page].ClearDirty();
+		}
+		if (mipLevels > 1)
+			texArray.GenMipmaps(0.0f);
+		return texArray;
+	}
+
+	void TextureAtlas::Update(Texture& texture, int page)
+	{
+		texture.Update(pages[page]);
+	}
+
+	// Mips are regenerated for the whole array when any page changed
+	void TextureAtlas::Update(TextureArray& texArray)
+	{
+		if ((int)pages.size() > texArray.layers)
+			throw std::runtime_error("TextureAtlas Error: Texture array has fewer layers than the atlas has pages\n");
+
+		bool changed = false;
+		for (int page = 0; page < (int)pages.size(); page++)
+		{
+			changed |= !pages[page].dirtyRects.empty();
+			texArray.UpdateLayer(pages[page], page);
+		}
+		if (changed && texArray.levels > 1)
+			texArray.GenMipmaps(0.0f);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "SimView.hpp"
+#include <cstring>
+
+namespace SimView
+{
+	TextureStreamer::TextureStreamer(size_t slotBytes, int slotCount)
+	{
+		this->slotBytes = (slotBytes + BitmapPool::Alignment - 1) & ~(BitmapPool::Alignment - 1);
+		slots.resize(slotCount);
+
+		// One persistently mapped pixel unpack buffer, split into slots that are each guarded by a fence
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, this->slotBytes * slotCount, nullptr, flags);
+		mapped = (unsigned char*)glMapNamedBufferRange(buffer, 0, this->slotBytes * slotCount, flags);
+		if (mapped == nullptr)
+		{
+			// The destructor does not run for a throwing constructor
+			glDeleteBuffers(1, &buffer);
+			buffer = 0;
+			throw std::runtime_error("TextureStreamer Error: Failed to map pixel buffer\n");
+		}
+		allocation = GpuAllocation(GpuResourceType::PixelBuffer, this->slotBytes * slotCount);
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		slots.clear();
+		glUnmapNamedBuffer(buffer);
+		glDeleteBuffers(1, &buffer);
+	}
+
+	size_t TextureStreamer::Stage(const Bitmap& image)
+	{
+		if (image.GetByteSize() > slotBytes)
+			throw std::runtime_error("TextureStreamer Error: Image is larger than a streaming slot\n");
+
+		// Only blocks if the GPU is still reading this slot from slotCount uploads ago
+		Slot& slot = slots[nextSlot];
+		slot.fence.Wait();
+
+		size_t offset = nextSlot * slotBytes;
+		std::memcpy(mapped + offset, image.data, image.GetByteSize());
+		return offset;
+	}
+
+	int TextureStreamer::Commit()
+	{
+		Slot& slot = slots[nextSlot];
+		slot.fence.Set();
+		slot.ticket = nextTicket;
+		nextSlot = (nextSlot + 1) % (int)slots.size();
+		return nextTicket++;
+	}
+
+	int TextureStreamer::Upload(Texture& texture, const Bitmap& image)
+	{
+		const PixelFormatInfo& info = PixelFormatInfo::Get(image.format);
+		size_t offset = Stage(image);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(image.width));
+		glTextureSubImage2D(texture.id, 0, 0, 0, image.width, image.height, info.format, info.type, (const void*)offset);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		return Commit();
+	}
+
+	int TextureStreamer::UploadLayer(TextureArray& texArray, const Bitmap& image, int layer)
+	{
+		const PixelFormatInfo& info = PixelFormatInfo::Get(image.format);
+		size_t offset = Stage(image);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, info.UnpackAlignment(image.width));
+		glTextureSubImage3D(texArray.id, 0, 0, 0, layer, image.width, image.height, 1, info.format, info.type, (const void*)offset);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		return Commit();
+	}
+
+	UploadStatus TextureStreamer::GetStatus(int ticket) const
+	{
+		if (ticket < 0 || ticket >= nextTicket)
+			throw std::runtime_error("TextureStreamer Error: Ticket was never issued\n");
+
+		for (const Slot& slot : slots)
+		{
+			if (slot.ticket == ticket)
+				return slot.fence.IsSignaled() ? UploadStatus::Complete : UploadStatus::InFlight;
+		}
+
+		// Tickets whose slot has been reused were waited on before the reuse
+		return UploadStatus::Complete;
+	}
+
+	void TextureStreamer::Finish()
+	{
+		for (const Slot& slot : slots)
+			slot.fence.Wait();
+	}
+}
\ No newline at end of file
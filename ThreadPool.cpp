@@ -0,0 +1,125 @@
+#include "SimView.hpp"
+#include <algorithm>
+#include <atomic>
+
+namespace SimView
+{
+	ThreadPool::ThreadPool(int threadCount)
+	{
+		if (threadCount <= 0)
+			threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+		for (int i = 0; i < threadCount; i++)
+			threads.emplace_back([this] { WorkerLoop(); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		taskCv.notify_all();
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	ThreadPool& ThreadPool::Shared()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	int ThreadPool::GetThreadCount() const
+	{
+		return (int)threads.size();
+	}
+
+	void ThreadPool::Submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(std::move(task));
+		}
+		taskCv.notify_one();
+	}
+
+	void ThreadPool::Wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		idleCv.wait(lock, [this] { return tasks.empty() && activeTasks == 0; });
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				taskCv.wait(lock, [this] { return stopping || !tasks.empty(); });
+				if (tasks.empty())
+					return;
+				task = std::move(tasks.front());
+				tasks.pop_front();
+				activeTasks++;
+			}
+
+			task();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				activeTasks--;
+				if (tasks.empty() && activeTasks == 0)
+					idleCv.notify_all();
+			}
+		}
+	}
+
+	struct ParallelForState
+	{
+		std::atomic<int> next = 0;
+		std::mutex mutex;
+		std::condition_variable doneCv;
+		int running = 0;
+		bool claimed = false;
+	};
+
+	void ThreadPool::ParallelFor(int count, const std::function<void(int)>& body)
+	{
+		if (count <= 0)
+			return;
+
+		// The caller works through items too, helpers that only start after every item is claimed exit immediately,
+		// so nested ParallelFor calls from worker threads can't deadlock
+		auto state = std::make_shared<ParallelForState>();
+		auto run = [state, count, &body]()
+		{
+			for (int i = state->next++; i < count; i = state->next++)
+				body(i);
+		};
+
+		int helpers = std::min(count - 1, GetThreadCount());
+		for (int i = 0; i < helpers; i++)
+		{
+			Submit([state, run]()
+			{
+				{
+					std::lock_guard<std::mutex> lock(state->mutex);
+					if (state->claimed)
+						return;
+					state->running++;
+				}
+				run();
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->running--;
+				state->doneCv.notify_all();
+			});
+		}
+
+		run();
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->claimed = true;
+		state->doneCv.wait(lock, [&state] { return state->running == 0; });
+	}
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "SimView.hpp"
+
+namespace SimView
+{
+	Half2 Half2::FromVec(glm::vec2 value)
+	{
+		return { Half::FromFloat(value.x), Half::FromFloat(value.y) };
+	}
+
+	Half4 Half4::FromVec(glm::vec4 value)
+	{
+		return { Half::FromFloat(value.x), Half::FromFloat(value.y), Half::FromFloat(value.z), Half::FromFloat(value.w) };
+	}
+
+	static std::uint32_t PackSnorm(float value, int bits)
+	{
+		int maxValue = (1 << (bits - 1)) - 1;
+		int packed = (int)std::round(std::clamp(value, -1.0f, 1.0f) * maxValue);
+		return std::uint32_t(packed) & ((1u << bits) - 1);
+	}
+
+	Packed1010102 Packed1010102::FromVec(glm::vec4 value)
+	{
+		return { PackSnorm(value.x, 10) | (PackSnorm(value.y, 10) << 10) | (PackSnorm(value.z, 10) << 20) | (PackSnorm(value.w, 2) << 30) };
+	}
+
+	// Appends after the last attribute, aligned to 4 bytes
+	VertexLayout& VertexLayout::Add(VertexFormat format, int components)
+	{
+		return Add(format, components, (stride + 3) & ~size_t(3));
+	}
+
+	VertexLayout& VertexLayout::Add(VertexFormat format, int components, size_t offset)
+	{
+		if (components < 1 || components > 4)
+			throw std::runtime_error("VertexLayout Error: Attributes must have 1 to 4 components\n");
+		if (format == VertexFormat::Packed1010102 && components != 4)
+			throw std::runtime_error("VertexLayout Error: Packed 10_10_10_2 attributes must have 4 components\n");
+
+		attributes.push_back({ format, components, offset });
+		stride = std::max(stride, offset + GetSize(format, components));
+		return *this;
+	}
+
+	size_t VertexLayout::GetSize(VertexFormat format, int components)
+	{
+		switch (format)
+		{
+		case VertexFormat::Float:
+		case VertexFormat::Int:
+			return 4 * components;
+		case VertexFormat::Half:
+		case VertexFormat::UShortNorm:
+			return 2 * components;
+		case VertexFormat::UByteNorm:
+			return components;
+		case VertexFormat::Packed1010102:
+			return 4;
+		}
+		return 0;
+	}
+}
\ No newline at end of file
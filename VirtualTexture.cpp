@@ -0,0 +1,219 @@
+#include "SimView.hpp"
+#include <atomic>
+
+namespace SimView
+{
+	struct LoadedTile
+	{
+		int tileId;
+		Bitmap image;
+		std::vector<Bitmap> mips;
+		bool failed;
+	};
+
+	struct VirtualTextureState
+	{
+		std::vector<std::string> paths;
+		int tileWidth;
+		int tileHeight;
+		int mipLevels;
+		ThreadPool* pool;
+		std::deque<LoadedTile> ready;
+		std::mutex mutex;
+		std::atomic<bool> cancelled = false;
+	};
+
+	VirtualTexture::VirtualTexture(int tileWidth, int tileHeight, int layerBudget, std::vector<std::string> tilePaths, int mipLevels, ThreadPool& pool)
+		: layers(tileWidth, tileHeight, layerBudget, mipLevels)
+	{
+		if (layerBudget < 2)
+			throw std::runtime_error("VirtualTexture Error: Layer budget must hold the fallback and at least one tile\n");
+
+		this->tileWidth = tileWidth;
+		this->tileHeight = tileHeight;
+		this->pool = &pool;
+		tiles.resize(tilePaths.size());
+
+		// Layer 0 holds the fallback, the rest are handed out to tiles
+		for (int layer = layerBudget - 1; layer > FallbackLayer; layer--)
+			freeLayers.push_back(layer);
+
+		state = std::make_shared<VirtualTextureState>();
+		state->paths = std::move(tilePaths);
+		state->tileWidth = tileWidth;
+		state->tileHeight = tileHeight;
+		state->mipLevels = mipLevels;
+		state->pool = &pool;
+
+		table.assign(tiles.size(), (std::int32_t)FallbackLayer);
+		dirtyBegin = (int)table.size();
+		size_t tableBytes = std::max<size_t>(table.size(), 1) * sizeof(std::int32_t);
+		glCreateBuffers(1, &indirection);
+		glNamedBufferStorage(indirection, tableBytes, table.empty() ? nullptr : table.data(), GL_DYNAMIC_STORAGE_BIT);
+		indirectionAllocation = GpuAllocation(GpuResourceType::VertexBuffer, tableBytes);
+
+		SetFallback(Bitmap::GetColorImage(tileWidth, tileHeight, Color(128, 128, 128, 255)));
+	}
+
+	VirtualTexture::~VirtualTexture()
+	{
+		state->cancelled = true;
+		glDeleteBuffers(1, &indirection);
+	}
+
+	static std::vector<Bitmap> TileMips(const Bitmap& image, int mipLevels, ThreadPool& pool)
+	{
+		if (mipLevels <= 1)
+			return {};
+		std::vector<Bitmap> mips = image.GenMipChain(ResampleFilter::Box, pool);
+		mips.resize(std::min<size_t>(mips.size(), mipLevels - 1));
+		return mips;
+	}
+
+	void VirtualTexture::UploadTile(int layer, Bitmap& image, const std::vector<Bitmap>& mips)
+	{
+		if (mips.empty())
+			layers.LayerFromBitmap(image, layer);
+		else
+			layers.LayerFromMipChain(image, mips, layer);
+	}
+
+	void VirtualTexture::SetFallback(const Bitmap& image)
+	{
+		Bitmap fallback = image;
+		if (image.width != tileWidth || image.height != tileHeight)
+			fallback = image.Resample(tileWidth, tileHeight, ResampleFilter::Bilinear, pool);
+		UploadTile(FallbackLayer, fallback, TileMips(fallback, layers.levels, *pool));
+	}
+
+	void VirtualTexture::Request(int tileId)
+	{
+		Tile& tile = tiles[tileId];
+		if (tile.layer != FallbackLayer)
+		{
+			lru.splice(lru.begin(), lru, tile.lruEntry);
+			return;
+		}
+		if (tile.loading || tile.failed)
+			return;
+
+		tile.loading = true;
+		pending++;
+		pool->Submit([state = state, tileId]()
+		{
+			if (state->cancelled)
+				return;
+
+			LoadedTile loaded = { tileId, Bitmap(), {}, false };
+			try
+			{
+				loaded.image = Bitmap::FromFile(state->paths[tileId]);
+				if (loaded.image.width != state->tileWidth || loaded.image.height != state->tileHeight)
+					loaded.image = loaded.image.Resample(state->tileWidth, state->tileHeight, ResampleFilter::Bilinear);
+				loaded.mips = TileMips(loaded.image, state->mipLevels, *state->pool);
+			}
+			catch (const std::exception&)
+			{
+				loaded.failed = true;
+			}
+
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->ready.push_back(std::move(loaded));
+		});
+	}
+
+	int VirtualTexture::AcquireLayer()
+	{
+		if (!freeLayers.empty())
+		{
+			int layer = freeLayers.back();
+			freeLayers.pop_back();
+			return layer;
+		}
+
+		// Evict the least recently requested tile, it falls back until requested again
+		int victim = lru.back();
+		lru.pop_back();
+		int layer = tiles[victim].layer;
+		tiles[victim].layer = FallbackLayer;
+		table[victim] = FallbackLayer;
+		dirtyBegin = std::min(dirtyBegin, victim);
+		dirtyEnd = std::max(dirtyEnd, victim + 1);
+		return layer;
+	}
+
+	int VirtualTexture::Update(int maxUploads)
+	{
+		int uploads = 0;
+		while (maxUploads < 0 || uploads < maxUploads)
+		{
+			LoadedTile loaded;
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (state->ready.empty())
+					break;
+				loaded = std::move(state->ready.front());
+				state->ready.pop_front();
+			}
+
+			Tile& tile = tiles[loaded.tileId];
+			tile.loading = false;
+			pending--;
+			if (loaded.failed)
+			{
+				tile.failed = true;
+				continue;
+			}
+
+			// Uploads happen on the calling thread, which owns the GL context
+			int layer = AcquireLayer();
+			UploadTile(layer, loaded.image, loaded.mips);
+			tile.layer = layer;
+			lru.push_front(loaded.tileId);
+			tile.lruEntry = lru.begin();
+			table[loaded.tileId] = layer;
+			dirtyBegin = std::min(dirtyBegin, loaded.tileId);
+			dirtyEnd = std::max(dirtyEnd, loaded.tileId + 1);
+			uploads++;
+		}
+
+		if (dirtyBegin < dirtyEnd)
+		{
+			glNamedBufferSubData(indirection, dirtyBegin * sizeof(std::int32_t), (dirtyEnd - dirtyBegin) * sizeof(std::int32_t), table.data() + dirtyBegin);
+		}
+		dirtyBegin = (int)table.size();
+		dirtyEnd = 0;
+		return uploads;
+	}
+
+	// Shaders read the table as "layout(std430) buffer { int layers[]; }" indexed by tile id
+	void VirtualTexture::BindIndirection(GLuint binding) const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, indirection);
+	}
+
+	bool VirtualTexture::IsResident(int tileId) const
+	{
+		return tiles[tileId].layer != FallbackLayer;
+	}
+
+	int VirtualTexture::GetLayer(int tileId) const
+	{
+		return tiles[tileId].layer;
+	}
+
+	int VirtualTexture::GetTileCount() const
+	{
+		return (int)tiles.size();
+	}
+
+	int VirtualTexture::GetResidentCount() const
+	{
+		return (int)lru.size();
+	}
+
+	int VirtualTexture::GetPendingCount() const
+	{
+		return pending;
+	}
+}
\ No newline at end of file
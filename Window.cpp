@@ -107,8 +107,8 @@ namespace SimView
 
         glfwSwapInterval(0);
 
-        glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
+        glCreateVertexArrays(1, &VAO);
+        Mesh::SetDefault(VAO);
 
         glEnable(GL_BLEND);
 
@@ -241,7 +241,8 @@ namespace SimView
 
     void Window::FillScreen(Color color)
     {
-        glClearColor(color.r / 255.f, color.g / 255.f, color.b / 255.f, color.a / 255.f);
+        FColor fColor = FColor::Convert(color);
+        glClearColor(fColor.r, fColor.g, fColor.b, fColor.a);
         glClear(GL_COLOR_BUFFER_BIT);
     }
 